@@ -0,0 +1,704 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+#include "Image.hpp"
+#include "Color.hpp"
+#include "Kernel.hpp"
+#include "Convolution.hpp"
+#include "FFTPlans.hpp"
+#include "PixelImage.hpp"
+#include "SpectrumStack.hpp"
+
+/// <summary>
+/// Settings of benchmark run parsed from command line.
+/// </summary>
+struct BenchSettings {
+    /// <summary> Smallest image side in pixels </summary>
+    int minSize = 256;
+    /// <summary> Largest image side in pixels </summary>
+    int maxSize = 16384;
+    /// <summary> Number of measured repetitions of each operation </summary>
+    int repetitions = 5;
+    /// <summary> Operations taking longer than this (estimated, in seconds) are skipped </summary>
+    double budget = 30.0;
+    /// <summary> Sigma of Gaussian kernel used for convolutions </summary>
+    float sigma = 1.0f;
+    /// <summary> Size of large non-separable kernel </summary>
+    int kernelSize = 31;
+    /// <summary> Substring filter of operation names, empty runs everything </summary>
+    std::string filter;
+    /// <summary> Optional path to CSV report </summary>
+    std::string csvPath;
+    /// <summary> Rigor of FFTW planning </summary>
+    FFTPlans::Rigor rigor = FFTPlans::Rigor::Estimate;
+    /// <summary> Optional path to FFTW wisdom loaded at start and saved at the end </summary>
+    std::string wisdomPath;
+    /// <summary> Number of FFTW threads, 0 keeps default (all cores) </summary>
+    int fftThreads = 0;
+};
+
+/// <summary>
+/// Single benchmarked operation.
+/// </summary>
+struct BenchCase {
+    /// <summary> Name of operation printed in report </summary>
+    std::string name;
+    /// <summary> Operation itself, measured as a whole </summary>
+    std::function<void(Image&)> run;
+    /// <summary> Whether operation modifies image data and it has to be restored before each run </summary>
+    bool modifiesData;
+    /// <summary> Optional unmeasured preparation done once per image size </summary>
+    std::function<void(Image&)> setup;
+    /// <summary> Optional unmeasured undoing of setup, so that following operations see default image state </summary>
+    std::function<void(Image&)> teardown = nullptr;
+};
+
+/// <summary>
+/// Statistics of measured operation.
+/// </summary>
+struct BenchResult {
+    std::string name;
+    int size;
+    int repetitions;
+    double meanMs;
+    double varianceMs2;
+};
+
+/// <summary>
+/// Prints instructions for tool usage.
+/// </summary>
+void printHelp() {
+    std::cout << "Benchmark of Image operations on synthetic images" << std::endl << std::endl;
+    std::cout << "Usage: aim_bench [options]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "[--min value] - smallest image side (default 256)" << std::endl;
+    std::cout << "[--max value] - largest image side (default 16384)" << std::endl;
+    std::cout << "[--reps value] - measured repetitions per operation (default 5)" << std::endl;
+    std::cout << "[--budget value] - skip operations estimated to take longer in seconds (default 30)" << std::endl;
+    std::cout << "[--sigma value] - sigma of Gaussian convolution kernel (default 1)" << std::endl;
+    std::cout << "[--kernel value] - size of large non-separable kernel (default 31)" << std::endl;
+    std::cout << "[--filter text] - run only operations containing text" << std::endl;
+    std::cout << "[--csv path] - also write results to CSV file" << std::endl;
+    std::cout << "[--rigor estimate|measure|patient] - FFTW planning rigor (default estimate)" << std::endl;
+    std::cout << "[--wisdom path] - load FFTW wisdom from file and save it back at the end" << std::endl;
+    std::cout << "[--fft-threads value] - threads of single FFT (default all cores)" << std::endl;
+}
+
+/// <summary>
+/// Parses command line arguments into settings.
+/// </summary>
+/// <returns>False when program should not continue.</returns>
+bool parseArguments(int argc, char** argv, BenchSettings& settings) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") {
+            printHelp();
+            return false;
+        }
+
+        if (i + 1 >= argc) {
+            std::cout << "Missing value for " << arg << std::endl;
+            return false;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--min") {
+            settings.minSize = std::stoi(value);
+        } else if (arg == "--max") {
+            settings.maxSize = std::stoi(value);
+        } else if (arg == "--reps") {
+            settings.repetitions = std::max(1, std::stoi(value));
+        } else if (arg == "--budget") {
+            settings.budget = std::stod(value);
+        } else if (arg == "--sigma") {
+            settings.sigma = std::stof(value);
+        } else if (arg == "--kernel") {
+            settings.kernelSize = std::stoi(value);
+        } else if (arg == "--filter") {
+            settings.filter = value;
+        } else if (arg == "--csv") {
+            settings.csvPath = value;
+        } else if (arg == "--rigor") {
+            if (value == "estimate") {
+                settings.rigor = FFTPlans::Rigor::Estimate;
+            } else if (value == "measure") {
+                settings.rigor = FFTPlans::Rigor::Measure;
+            } else if (value == "patient") {
+                settings.rigor = FFTPlans::Rigor::Patient;
+            } else {
+                std::cout << "Unknown rigor " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--wisdom") {
+            settings.wisdomPath = value;
+        } else if (arg == "--fft-threads") {
+            settings.fftThreads = std::stoi(value);
+        } else {
+            std::cout << "Unknown option " << arg << std::endl;
+            printHelp();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Generates deterministic grayscale test pattern (gradient, waves and noise) in <0,1) range.
+/// </summary>
+std::vector<float> createSyntheticData(int size) {
+    std::vector<float> result(static_cast<size_t>(size) * size);
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            float u = (float)x / size;
+            float v = (float)y / size;
+            float value = 0.3f * u + 0.2f * v + 0.2f * sinf(40.0f * u) * cosf(25.0f * v) + 0.3f + noise(generator);
+
+            result[static_cast<size_t>(y) * size + x] = std::clamp(value, 0.001f, 0.999f);
+        }
+    }
+
+    return result;
+}
+
+/// <summary>
+/// Creates list of all benchmarked operations.
+/// </summary>
+std::vector<BenchCase> createCases(const BenchSettings& settings) {
+    using Op = Image::MonadicOperationType;
+    std::vector<BenchCase> cases;
+
+    auto monadic = [&cases](std::string name, Op operation, float value) {
+        cases.push_back({
+            name,
+            [operation, value](Image& image) {
+                image.doOperation(operation, value, false);
+                image.evaluate();
+            },
+            true,
+            nullptr
+        });
+    };
+
+    monadic("negative", Op::NEGATIVE, 0.0f);
+    monadic("threshold", Op::THRESHOLD, 0.5f);
+    monadic("brightness", Op::BRIGHTNESS, 0.1f);
+    monadic("contrast", Op::CONTRAST, 1.2f);
+    monadic("gamma", Op::GAMMA_CORRECTION, 2.2f);
+    monadic("quantization", Op::QUANTIZATION, 8.0f);
+    monadic("equalization", Op::HISTOGRAM_EQUALIZATION, 0.0f);
+    monadic("clahe_8x8", Op::ADAPTIVE_HISTOGRAM_EQUALIZATION, 3.0f);
+
+    cases.push_back({
+        "histogram",
+        [](Image& image) { image.computeHistogram(); },
+        false,
+        nullptr
+    });
+    cases.push_back({
+        "histogram_65536",
+        [](Image& image) { image.computeHistogram(); },
+        false,
+        [](Image& image) { image.setHistogramBins(65536); },
+        [](Image& image) { image.setHistogramBins(256); }
+    });
+    cases.push_back({
+        "chain_separate",
+        [](Image& image) {
+            image.doOperation(Op::BRIGHTNESS, 0.1f, false);
+            image.evaluate();
+            image.doOperation(Op::CONTRAST, 1.2f, false);
+            image.evaluate();
+            image.doOperation(Op::GAMMA_CORRECTION, 2.2f, false);
+            image.evaluate();
+            image.doOperation(Op::QUANTIZATION, 8.0f, false);
+            image.evaluate();
+        },
+        true,
+        nullptr
+    });
+    cases.push_back({
+        "chain_fused",
+        [](Image& image) {
+            image.applyOperations({{Op::BRIGHTNESS, 0.1f}, {Op::CONTRAST, 1.2f}, {Op::GAMMA_CORRECTION, 2.2f}, {Op::QUANTIZATION, 8.0f}});
+        },
+        true,
+        nullptr
+    });
+    cases.push_back({
+        "tweaks_lazy",
+        [](Image& image) {
+            // Sliders dragged through many values, consecutive tweaks merge into one operation each
+            for (int i = 0; i < 100; i++) {
+                image.doOperation(Op::BRIGHTNESS, 0.001f, false);
+            }
+            for (int i = 0; i < 100; i++) {
+                image.doOperation(Op::GAMMA_CORRECTION, 1.01f, false);
+            }
+            image.evaluate();
+        },
+        true,
+        nullptr
+    });
+    cases.push_back({
+        "gamma_lut8",
+        [](Image& image) { image.applyLookupTable({{Op::GAMMA_CORRECTION, 2.2f}}, 8); },
+        true,
+        nullptr
+    });
+    cases.push_back({
+        "gamma_lut16",
+        [](Image& image) { image.applyLookupTable({{Op::GAMMA_CORRECTION, 2.2f}}, 16); },
+        true,
+        nullptr
+    });
+
+    // Compact pixels converted from image once per size, operations modify them in place
+    auto compact8 = std::make_shared<PixelImage<uint8_t>>();
+    auto compactHalf = std::make_shared<PixelImage<Pixel::Half>>();
+    auto convert8 = [compact8](Image& image) { *compact8 = PixelImage<uint8_t>(image); };
+    auto convertHalf = [compactHalf](Image& image) { *compactHalf = PixelImage<Pixel::Half>(image); };
+
+    cases.push_back({
+        "u8_chain",
+        [compact8](Image&) {
+            compact8->applyOperations({{Op::BRIGHTNESS, 0.1f}, {Op::CONTRAST, 1.2f}, {Op::GAMMA_CORRECTION, 2.2f}, {Op::QUANTIZATION, 8.0f}});
+        },
+        false,
+        convert8
+    });
+    cases.push_back({
+        "u8_histogram",
+        [compact8](Image&) { compact8->computeHistogram(); },
+        false,
+        convert8
+    });
+    cases.push_back({
+        "half_chain",
+        [compactHalf](Image&) {
+            compactHalf->applyOperations({{Op::BRIGHTNESS, 0.1f}, {Op::CONTRAST, 1.2f}, {Op::GAMMA_CORRECTION, 2.2f}, {Op::QUANTIZATION, 8.0f}});
+        },
+        false,
+        convertHalf
+    });
+
+    cases.push_back({
+        "spectrum",
+        [](Image& image) { image.computeSpectrum(); },
+        false,
+        nullptr
+    });
+    cases.push_back({
+        "reconstruct",
+        [](Image& image) { std::vector<float> restored = image.reconstructImageFromSpectrum(); },
+        false,
+        [](Image& image) { image.computeSpectrum(); }
+    });
+    cases.push_back({
+        "spectrum_r2c",
+        [](Image& image) { image.computeSpectrum(Image::SpectrumMode::REAL_FLOAT); },
+        false,
+        nullptr
+    });
+    cases.push_back({
+        "reconstruct_r2c",
+        [](Image& image) { std::vector<float> restored = image.reconstructImageFromSpectrum(); },
+        false,
+        [](Image& image) { image.computeSpectrum(Image::SpectrumMode::REAL_FLOAT); }
+    });
+    cases.push_back({
+        "spectrum_filter",
+        [](Image& image) {
+            Spectrum::Filter filter;
+            filter.type = Spectrum::FilterType::BandPass;
+            filter.shape = Spectrum::FilterShape::Gaussian;
+            image.filterSpectrum(filter, false);
+        },
+        false,
+        [](Image& image) { image.computeSpectrum(Image::SpectrumMode::REAL_FLOAT); }
+    });
+    // Stack of 8 images (the same image, every plane is a frame), time is for whole stack, buffer is reused between runs
+    std::shared_ptr<SpectrumStack> stack = std::make_shared<SpectrumStack>();
+    cases.push_back({
+        "spectrum_stack8",
+        [stack](Image& image) { stack->compute(std::vector<Image*>(8, &image)); },
+        false,
+        nullptr
+    });
+
+    Kernel gauss(3);
+    gauss.CreateGauss(settings.sigma);
+
+    cases.push_back({
+        "convolute_1d",
+        [gauss](Image& image) mutable {
+            std::vector<float> destination;
+            image.Convolute(gauss, Kernel::Type::Kernel_1D, destination);
+        },
+        false,
+        nullptr
+    });
+    cases.push_back({
+        "convolute_2d",
+        [gauss](Image& image) mutable {
+            std::vector<float> destination;
+            image.Convolute(gauss, Kernel::Type::Kernel_2D, destination);
+        },
+        false,
+        nullptr
+    });
+
+    cases.push_back({
+        "convolute_fft",
+        [gauss](Image& image) mutable {
+            std::vector<float> destination;
+            image.Convolute(gauss, Kernel::Type::Kernel_FFT, destination);
+        },
+        false,
+        nullptr
+    });
+    cases.push_back({
+        "convolute_auto",
+        [gauss](Image& image) mutable {
+            std::vector<float> destination;
+            image.Convolute(gauss, Kernel::Type::Kernel_Auto, destination);
+        },
+        false,
+        nullptr
+    });
+
+    cases.push_back({
+        "u8_convolute",
+        [gauss, compact8](Image&) mutable {
+            PixelImage<uint8_t> destination;
+            compact8->Convolute(gauss, destination);
+        },
+        false,
+        convert8
+    });
+
+    // Interleaved RGB pixels made from image once per size, decoded to planes of colour space
+    auto interleaved = std::make_shared<std::vector<uint8_t>>();
+    auto interleave = [interleaved](Image& image) {
+        interleaved->resize(image.data.size() * 3);
+        Color::Encode(image.data.data(), Color::Space::LUMINANCE, image.width, image.height, Color::Layout::RGB, interleaved->data());
+    };
+    for (auto [name, space] : {
+        std::pair{ "decode_luminance", Color::Space::LUMINANCE },
+        std::pair{ "decode_ycbcr", Color::Space::YCBCR },
+        std::pair{ "decode_hsv", Color::Space::HSV }
+    }) {
+        cases.push_back({
+            name,
+            [interleaved, space](Image& image) {
+                std::vector<float> planes(image.data.size() * Color::Planes(space));
+                Color::Decode(interleaved->data(), Color::Layout::RGB, image.width, image.height, space, planes.data());
+            },
+            false,
+            interleave
+        });
+    }
+
+    // Three planes (copies of image) convoluted in parallel, time is for all channels
+    auto color = std::make_shared<std::unique_ptr<Image>>();
+    cases.push_back({
+        "rgb_convolute_auto",
+        [gauss, color](Image&) mutable {
+            std::vector<float> destination;
+            (*color)->Convolute(gauss, Kernel::Type::Kernel_Auto, destination);
+        },
+        false,
+        [color](Image& image) {
+            std::vector<float> planes;
+            for (int c = 0; c < 3; c++) {
+                planes.insert(planes.end(), image.data.begin(), image.data.end());
+            }
+            *color = std::make_unique<Image>(planes, "bench_rgb.jpg", image.width, image.height, 3);
+        }
+    });
+
+    // Large non-separable kernel (random values) typical for deblurring
+    std::vector<float> randomValues(settings.kernelSize * settings.kernelSize);
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    for (float& value : randomValues) {
+        value = distribution(generator) / randomValues.size();
+    }
+    Kernel large(settings.kernelSize);
+    large.CreateFromValues(randomValues);
+
+    for (auto [name, type] : {
+        std::pair{ "large_2d", Kernel::Type::Kernel_2D },
+        std::pair{ "large_fft", Kernel::Type::Kernel_FFT },
+        std::pair{ "large_auto", Kernel::Type::Kernel_Auto }
+    }) {
+        cases.push_back({
+            name,
+            [large, type](Image& image) mutable {
+                std::vector<float> destination;
+                image.Convolute(large, type, destination);
+            },
+            false,
+            nullptr
+        });
+    }
+
+    // Recursive Gaussian should take the same time for any sigma
+    for (float sigma : { settings.sigma, 50.0f }) {
+        std::ostringstream name;
+        name << "recursive_gauss_s" << sigma;
+
+        cases.push_back({
+            name.str(),
+            [sigma](Image& image) {
+                std::vector<float> destination;
+                image.ApplyRecursiveGaussFilter(sigma, destination);
+            },
+            false,
+            nullptr
+        });
+    }
+
+    // Single passes of separable convolution, vertical one in both memory access orders
+    std::vector<float> xTaps;
+    std::vector<float> yTaps;
+    gauss.SplitInto1DKernels(xTaps, yTaps);
+
+    // Output buffer allocated outside of measurement so page faults do not hide pass itself
+    auto scratch = std::make_shared<std::vector<float>>();
+    auto allocateScratch = [scratch](Image& image) { scratch->assign(image.data.size(), 0.0f); };
+
+    cases.push_back({
+        "pass_horizontal",
+        [xTaps, scratch](Image& image) {
+            std::vector<float>& destination = *scratch;
+            Convolution::HorizontalPass(image.data.data(), destination.data(), image.width, image.height, xTaps);
+        },
+        false,
+        allocateScratch
+    });
+    cases.push_back({
+        "pass_vertical_rows",
+        [yTaps, scratch](Image& image) {
+            std::vector<float>& destination = *scratch;
+            Convolution::VerticalPass(image.data.data(), destination.data(), image.width, image.height, yTaps, Convolution::VerticalStrategy::FullRows);
+        },
+        false,
+        allocateScratch
+    });
+    cases.push_back({
+        "pass_vertical_strips",
+        [yTaps, scratch](Image& image) {
+            std::vector<float>& destination = *scratch;
+            Convolution::VerticalPass(image.data.data(), destination.data(), image.width, image.height, yTaps, Convolution::VerticalStrategy::ColumnStrips);
+        },
+        false,
+        allocateScratch
+    });
+
+    cases.push_back({
+        "bilateral",
+        [](Image& image) {
+            std::vector<float> destination;
+            image.ApplyBilateralFilter(3.0f, 1.0f, destination);
+        },
+        false,
+        nullptr
+    });
+    cases.push_back({
+        "bilateral_o1",
+        [](Image& image) {
+            std::vector<float> destination;
+            image.ApplyBilateralFilter(3.0f, 1.0f, destination, Image::BilateralMethod::CONSTANT_TIME);
+        },
+        false,
+        nullptr
+    });
+    cases.push_back({
+        "bilateral_o1_s6",
+        [](Image& image) {
+            std::vector<float> destination;
+            image.ApplyBilateralFilter(6.0f, 6.0f, destination, Image::BilateralMethod::CONSTANT_TIME);
+        },
+        false,
+        nullptr
+    });
+    cases.push_back({
+        "guided_r8",
+        [](Image& image) {
+            std::vector<float> destination;
+            image.ApplyGuidedFilter(image, 8, 0.01f, destination);
+        },
+        false,
+        nullptr
+    });
+    cases.push_back({
+        "sauvola_r50",
+        [](Image& image) {
+            std::vector<float> destination;
+            image.ApplyAdaptiveThreshold(Image::AdaptiveThresholdMethod::SAUVOLA, 50, 0.34f, destination);
+        },
+        false,
+        nullptr
+    });
+
+    return cases;
+}
+
+/// <summary>
+/// Runs given operation on image repeatedly and measures its statistics.
+/// </summary>
+BenchResult measure(BenchCase& benchCase, Image& image, const std::vector<float>& pristine, int repetitions) {
+    std::vector<double> times;
+
+    // First run is warm-up and is not part of results
+    for (int i = 0; i <= repetitions; i++) {
+        if (benchCase.modifiesData) {
+            image.data = pristine;
+            image.markModified();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        benchCase.run(image);
+        auto end = std::chrono::steady_clock::now();
+
+        if (i > 0) {
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+
+    double mean = 0.0;
+    for (double t : times) {
+        mean += t;
+    }
+    mean /= times.size();
+
+    double variance = 0.0;
+    for (double t : times) {
+        variance += (t - mean) * (t - mean);
+    }
+    variance = times.size() > 1 ? variance / (times.size() - 1) : 0.0;
+
+    return { benchCase.name, image.width, repetitions, mean, variance };
+}
+
+/// <summary>
+/// Prints single result line into console.
+/// </summary>
+void printResult(const BenchResult& result) {
+    double pixels = (double)result.size * result.size;
+    double stddev = sqrt(result.varianceMs2);
+
+    std::cout << std::left << std::setw(22) << result.name
+        << std::right << std::setw(7) << result.size
+        << std::fixed << std::setprecision(3)
+        << std::setw(14) << result.meanMs
+        << std::setw(12) << stddev
+        << std::setprecision(2)
+        << std::setw(9) << (result.meanMs > 0.0 ? 100.0 * stddev / result.meanMs : 0.0)
+        << std::setw(12) << pixels / (result.meanMs * 1e3)
+        << std::setprecision(3)
+        << std::setw(12) << result.meanMs * 1e6 / pixels
+        << std::endl;
+}
+
+int main(int argc, char** argv) {
+    BenchSettings settings;
+    if (!parseArguments(argc, argv, settings)) {
+        return 1;
+    }
+
+    // Plans are created during warm-up run, so planning time is not measured
+    FFTPlans::Initialize(settings.wisdomPath, settings.rigor);
+    if (settings.fftThreads > 0) {
+        FFTPlans::SetThreads(settings.fftThreads);
+    }
+
+    std::vector<BenchCase> cases = createCases(settings);
+    std::vector<BenchResult> results;
+
+    // Last measured time per pixel of each operation, used to estimate whether next size fits into budget
+    std::vector<double> lastNsPerPixel(cases.size(), 0.0);
+
+    std::cout << std::left << std::setw(22) << "operation"
+        << std::right << std::setw(7) << "size"
+        << std::setw(14) << "mean [ms]"
+        << std::setw(12) << "std [ms]"
+        << std::setw(9) << "cv [%]"
+        << std::setw(12) << "MPix/s"
+        << std::setw(12) << "ns/pixel"
+        << std::endl;
+
+    for (int size = settings.minSize; size <= settings.maxSize; size *= 2) {
+        std::vector<float> pristine = createSyntheticData(size);
+        Image image(pristine, "bench.jpg", size, size, 3);
+
+        for (size_t c = 0; c < cases.size(); c++) {
+            BenchCase& benchCase = cases[c];
+            if (!settings.filter.empty() && benchCase.name.find(settings.filter) == std::string::npos) {
+                continue;
+            }
+
+            double pixels = (double)size * size;
+            double estimatedSeconds = lastNsPerPixel[c] * pixels * (settings.repetitions + 1) * 1e-9;
+            if (estimatedSeconds > settings.budget) {
+                std::cout << std::left << std::setw(22) << benchCase.name
+                    << std::right << std::setw(7) << size
+                    << "   skipped (estimated " << std::setprecision(1) << std::fixed << estimatedSeconds << " s)"
+                    << std::endl;
+                continue;
+            }
+
+            image.data = pristine;
+            image.markModified();
+            if (benchCase.setup) {
+                benchCase.setup(image);
+            }
+
+            BenchResult result = measure(benchCase, image, pristine, settings.repetitions);
+            lastNsPerPixel[c] = result.meanMs * 1e6 / pixels;
+            if (benchCase.teardown) {
+                benchCase.teardown(image);
+            }
+
+            printResult(result);
+            results.push_back(result);
+        }
+    }
+
+    if (!settings.csvPath.empty()) {
+        std::ofstream csv(settings.csvPath);
+        csv << "operation,size,repetitions,mean_ms,variance_ms2,mpix_per_s,ns_per_pixel" << std::endl;
+
+        for (const BenchResult& result : results) {
+            double pixels = (double)result.size * result.size;
+            csv << result.name << ","
+                << result.size << ","
+                << result.repetitions << ","
+                << result.meanMs << ","
+                << result.varianceMs2 << ","
+                << pixels / (result.meanMs * 1e3) << ","
+                << result.meanMs * 1e6 / pixels
+                << std::endl;
+        }
+    }
+
+    FFTPlans::Shutdown();
+
+    return 0;
+}
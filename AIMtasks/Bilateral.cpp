@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cmath>
+#include <execution>
+
+#include "Bilateral.hpp"
+#include "Convolution.hpp"
+#include "ImageBuffer.hpp"
+#include "Simd.hpp"
+#include "Utils.hpp"
+
+namespace Bilateral
+{
+	/// <summary> Smallest intensity taken into logarithm </summary>
+	static const float MinimumIntensity = 1e-4f;
+
+	/// <summary> Number of samples of range weight table </summary>
+	static const int RangeTableSize = 16384;
+
+	/// <summary> Exponent -(difference * brightnessSigma)^2 / 2 at which range weight table ends </summary>
+	static const float RangeTableCutoff = 40.0f;
+
+	int WindowSize(float spatialSigma)
+	{
+		return static_cast<int>(6 * spatialSigma + 1);
+	}
+
+	void ConstantTime(
+		const std::vector<float>& source,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma,
+		int levels
+	) {
+		ConstantTime(source, source, destination, width, height, spatialSigma, brightnessSigma, levels);
+	}
+
+	void ConstantTime(
+		const std::vector<float>& source,
+		const std::vector<float>& guide,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma,
+		int levels
+	) {
+		destination.resize(source.size());
+		ConstantTime(source.data(), guide.data(), destination.data(), width, height, spatialSigma, brightnessSigma, levels);
+	}
+
+	void ConstantTime(
+		const float* source,
+		const float* guide,
+		float* destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma,
+		int levels
+	) {
+		const size_t size = static_cast<size_t>(width) * height;
+		const int radius = WindowSize(spatialSigma) / 2;
+
+		std::vector<float> logPlane(size);
+		std::transform(std::execution::par_unseq, guide, guide + size, logPlane.begin(), [](float value) {
+			return std::log(std::max(value, MinimumIntensity));
+		});
+
+		const auto [minimumIt, maximumIt] = std::minmax_element(std::execution::par_unseq, logPlane.begin(), logPlane.end());
+		const float minimum = *minimumIt;
+		const float range = *maximumIt - minimum;
+
+		std::fill(destination, destination + size, 0.0f);
+
+		// Flat guide, range weights are all equal
+		if (range < 1e-6f) {
+			Convolution::Box(source, destination, width, height, radius);
+			return;
+		}
+
+		if (levels <= 0) {
+			levels = static_cast<int>(std::ceil(range * brightnessSigma)) + 1;
+		}
+		levels = std::clamp(levels, 2, 256);
+
+		const float step = range / (levels - 1);
+		const float exponentScale = -0.5f * brightnessSigma * brightnessSigma;
+
+		std::vector<float> weights(size);
+		std::vector<float> weighted(size);
+
+		for (int level = 0; level < levels; level++) {
+			const float levelValue = minimum + level * step;
+
+			// Range weight of every pixel against intensity of this level
+			Utils::ParallelBands(height, [&](int begin, int end) {
+				const size_t first = static_cast<size_t>(begin) * width;
+				const size_t last = static_cast<size_t>(end) * width;
+				const Simd::Float levelVector = Simd::broadcast(levelValue);
+				const Simd::Float scaleVector = Simd::broadcast(exponentScale);
+
+				size_t i = first;
+				for (; i + Simd::width <= last; i += Simd::width) {
+					Simd::Float difference = Simd::sub(levelVector, Simd::load(logPlane.data() + i));
+					Simd::Float weight = Simd::exp(Simd::mul(Simd::mul(difference, difference), scaleVector));
+
+					Simd::store(weights.data() + i, weight);
+					Simd::store(weighted.data() + i, Simd::mul(weight, Simd::load(source + i)));
+				}
+				for (; i < last; i++) {
+					float difference = levelValue - logPlane[i];
+					weights[i] = std::exp(difference * difference * exponentScale);
+					weighted[i] = weights[i] * source[i];
+				}
+			});
+
+			Convolution::Box(weights.data(), weights.data(), width, height, radius);
+			Convolution::Box(weighted.data(), weighted.data(), width, height, radius);
+
+			// Pixels between this and neighbouring level take their part of filtered value of this level
+			Utils::ParallelBands(height, [&](int begin, int end) {
+				const size_t last = static_cast<size_t>(end) * width;
+
+				for (size_t i = static_cast<size_t>(begin) * width; i < last; i++) {
+					float position = (logPlane[i] - minimum) / step;
+					int lower = std::min(static_cast<int>(position), levels - 2);
+					float fraction = position - lower;
+
+					float value = weighted[i] / std::max(weights[i], 1e-30f);
+					if (lower == level) {
+						destination[i] += (1.0f - fraction) * value;
+					} else if (lower + 1 == level) {
+						destination[i] += fraction * value;
+					}
+				}
+			});
+		}
+	}
+
+	void Exact(
+		const std::vector<float>& source,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma
+	) {
+		Exact(source, source, destination, width, height, spatialSigma, brightnessSigma);
+	}
+
+	void Exact(
+		const std::vector<float>& source,
+		const std::vector<float>& guide,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma
+	) {
+		destination.resize(source.size());
+		Exact(source.data(), guide.data(), destination.data(), width, height, spatialSigma, brightnessSigma);
+	}
+
+	void Exact(
+		const float* source,
+		const float* guide,
+		float* destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma
+	) {
+		const int filterSize = WindowSize(spatialSigma);
+		const int center = filterSize / 2;
+
+		// Spatial weight depends on tap offset only
+		std::vector<float> spatialWeights(static_cast<size_t>(filterSize) * filterSize);
+		for (int fy = 0; fy < filterSize; fy++) {
+			int yOffset = fy - center;
+			for (int fx = 0; fx < filterSize; fx++) {
+				int xOffset = fx - center;
+
+				// Same expression as per pixel evaluation, so that weights match it exactly
+				float deltaX = (float)(xOffset - fx) / (float)filterSize;
+				float deltaY = (float)(yOffset - fy) / (float)filterSize;
+				float distFromCenter = sqrtf((deltaX * deltaX) + (deltaY * deltaY));
+
+				spatialWeights[fy * filterSize + fx] = Utils::GaussianValue(distFromCenter, spatialSigma);
+			}
+		}
+
+		// Range weight sampled over absolute difference of logarithms
+		const float tableRange = std::sqrt(2.0f * RangeTableCutoff) / std::max(brightnessSigma, 1e-6f);
+		const float tableScale = (RangeTableSize - 1) / tableRange;
+		std::vector<float> rangeWeights(RangeTableSize);
+		for (int i = 0; i < RangeTableSize; i++) {
+			rangeWeights[i] = Utils::GaussianValue(i / tableScale, brightnessSigma);
+		}
+
+		// Apron of window radius replaces clamping of rows and columns of window
+		const size_t size = static_cast<size_t>(width) * height;
+		std::vector<float> guideLog(size);
+		std::transform(std::execution::par_unseq, guide, guide + size, guideLog.begin(), [](float value) {
+			return std::log(std::max(value, MinimumIntensity));
+		});
+
+		const ImageBuffer paddedIntensity(source, width, height, center);
+		const ImageBuffer paddedLog(guideLog.data(), width, height, center);
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			const Simd::Float scale = Simd::broadcast(tableScale);
+			const Simd::Float half = Simd::broadcast(0.5f);
+			const Simd::Float lastIndex = Simd::broadcast(static_cast<float>(RangeTableSize - 1));
+			float result[Simd::width];
+
+			for (int y = begin; y < end; y++) {
+				const float* centerLogRow = paddedLog.row(y);
+
+				for (int x = 0; x < width; x += Simd::width) {
+					const Simd::Float centerLog = Simd::load(centerLogRow + x);
+					Simd::Float intensitySum = Simd::zero();
+					Simd::Float normalization = Simd::zero();
+
+					for (int fy = 0; fy < filterSize; fy++) {
+						const float* logRow = paddedLog.row(y + fy - center) + x - center;
+						const float* intensityRow = paddedIntensity.row(y + fy - center) + x - center;
+						const float* spatialRow = spatialWeights.data() + fy * filterSize;
+
+						for (int fx = 0; fx < filterSize; fx++) {
+							Simd::Float difference = Simd::abs(Simd::sub(centerLog, Simd::load(logRow + fx)));
+							Simd::Float index = Simd::min(Simd::mulAdd(difference, scale, half), lastIndex);
+							Simd::Float weight = Simd::mul(Simd::lookup(rangeWeights.data(), index), Simd::broadcast(spatialRow[fx]));
+
+							intensitySum = Simd::mulAdd(weight, Simd::load(intensityRow + fx), intensitySum);
+							normalization = Simd::add(normalization, weight);
+						}
+					}
+
+					// Lanes behind end of row were computed from padding, they are not stored
+					Simd::store(result, Simd::div(intensitySum, normalization));
+					std::copy(result, result + std::min(Simd::width, width - x), destination + static_cast<size_t>(y) * width + x);
+				}
+			}
+		});
+	}
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <vector>
+
+/// <summary>
+/// Namespace with bilateral filtering engines working on raw grayscale float buffers.
+///
+/// All of them follow definition of Image::ApplyBilateralFilter: window of 6 * spatialSigma + 1 pixels
+/// clamped at image border and range weight exp(-(log(I(p)) - log(I(q)))^2 * brightnessSigma^2 / 2)
+/// (see Utils::GaussianValue). Spatial weight of that definition is the same for all taps of window,
+/// so spatially it is a box filter.
+/// </summary>
+namespace Bilateral
+{
+	/// <summary>
+	/// Size of filter window for given spatial sigma.
+	/// </summary>
+	int WindowSize(float spatialSigma);
+
+	/// <summary>
+	/// Exact bilateral filter, same result as original per pixel evaluation of Image::ApplyBilateralFilter.
+	///
+	/// Spatial weights of all filterSize^2 taps are computed once per call, logarithm of every pixel once
+	/// per image and range weight is read from table of 16384 values sampled over |log difference| (nearest
+	/// sample, beyond last sample weight is below 1e-17). Simd::width neighbouring output pixels are computed
+	/// at once from copies with apron of replicated border pixels (see ImageBuffer), bands of rows run in parallel.
+	/// Measured against per pixel evaluation on <0,1> images (sigma 0.5/0.3 - 3/4): largest difference below 2e-5.
+	/// Intensities are clamped to 1e-4 before logarithm (original evaluation gives NaN for zero pixels).
+	/// </summary>
+	/// <param name="source">Input image data</param>
+	/// <param name="destination">Vector where to save filtered image</param>
+	/// <param name="width">Width of image</param>
+	/// <param name="height">Height of image</param>
+	/// <param name="spatialSigma">Parameter of distance influence</param>
+	/// <param name="brightnessSigma">Parameter of color difference influence</param>
+	void Exact(
+		const std::vector<float>& source,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma
+	);
+
+	/// <summary>
+	/// Joint (cross) variant of Exact: source is averaged, but range weights are computed from guide
+	/// (e.g. depth map smoothed along edges of luminance image of the same size).
+	/// </summary>
+	/// <param name="source">Input image data</param>
+	/// <param name="guide">Image data whose edges are preserved</param>
+	/// <param name="destination">Vector where to save filtered image</param>
+	/// <param name="width">Width of both images</param>
+	/// <param name="height">Height of both images</param>
+	/// <param name="spatialSigma">Parameter of distance influence</param>
+	/// <param name="brightnessSigma">Parameter of color difference influence</param>
+	void Exact(
+		const std::vector<float>& source,
+		const std::vector<float>& guide,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma
+	);
+
+	/// <summary>
+	/// Joint variant of Exact on raw buffers of width * height values (guide may be source itself).
+	/// </summary>
+	void Exact(
+		const float* source,
+		const float* guide,
+		float* destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma
+	);
+
+	/// <summary>
+	/// Bilateral filter in constant time per pixel (Yang, Tan, Ahuja: Real-time O(1) bilateral filtering, 2009).
+	///
+	/// Range of log intensities is sampled by levels, for each level image weighted by range kernel of that
+	/// level is box filtered (running sums, independent of window size), result of pixel is linearly
+	/// interpolated from two levels nearest to its own intensity. Cost grows with number of levels only.
+	///
+	/// Default number of levels spaces them by one standard deviation of range kernel (1 / brightnessSigma).
+	/// Measured against exact filter on <0,1> images with textures, noise and sharp edges (sigma 3/1, 3/4,
+	/// 6/6, 5/6.5): mean absolute difference 4e-5 - 3e-3, largest difference up to 0.04 on isolated
+	/// pixels next to strong edges, doubling number of levels cuts both about four times.
+	/// Intensities are clamped to 1e-4 before logarithm (exact filter is undefined for zero pixels).
+	/// </summary>
+	/// <param name="source">Input image data</param>
+	/// <param name="destination">Vector where to save filtered image</param>
+	/// <param name="width">Width of image</param>
+	/// <param name="height">Height of image</param>
+	/// <param name="spatialSigma">Parameter of distance influence</param>
+	/// <param name="brightnessSigma">Parameter of color difference influence</param>
+	/// <param name="levels">Number of range levels, 0 chooses it from brightnessSigma</param>
+	void ConstantTime(
+		const std::vector<float>& source,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma,
+		int levels = 0
+	);
+
+	/// <summary>
+	/// Joint (cross) variant of ConstantTime, range levels are sampled from guide.
+	/// </summary>
+	/// <param name="source">Input image data</param>
+	/// <param name="guide">Image data whose edges are preserved</param>
+	/// <param name="destination">Vector where to save filtered image</param>
+	/// <param name="width">Width of both images</param>
+	/// <param name="height">Height of both images</param>
+	/// <param name="spatialSigma">Parameter of distance influence</param>
+	/// <param name="brightnessSigma">Parameter of color difference influence</param>
+	/// <param name="levels">Number of range levels, 0 chooses it from brightnessSigma</param>
+	void ConstantTime(
+		const std::vector<float>& source,
+		const std::vector<float>& guide,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma,
+		int levels = 0
+	);
+
+	/// <summary>
+	/// Joint variant of ConstantTime on raw buffers of width * height values (guide may be source itself).
+	/// </summary>
+	void ConstantTime(
+		const float* source,
+		const float* guide,
+		float* destination,
+		int width,
+		int height,
+		float spatialSigma,
+		float brightnessSigma,
+		int levels = 0
+	);
+}
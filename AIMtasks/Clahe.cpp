@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "Clahe.hpp"
+#include "Simd.hpp"
+#include "Utils.hpp"
+
+namespace Clahe
+{
+	/// <summary>
+	/// Part of row between centres of two neighbouring tiles (or between border and the nearest centre).
+	/// </summary>
+	struct Segment {
+		int begin;
+		int end;
+		int tile0;
+		int tile1;
+	};
+
+	/// <summary>
+	/// Start of tile along axis of given length, the last tile ends at length.
+	/// </summary>
+	static inline int TileStart(int tile, int tiles, int length)
+	{
+		return static_cast<int>(static_cast<int64_t>(tile) * length / tiles);
+	}
+
+	/// <summary>
+	/// Finds two tiles interpolated at pixel centre and weight of the second one.
+	/// </summary>
+	static void NearestTiles(const std::vector<float>& centres, float position, int& tile0, int& tile1, float& weight)
+	{
+		const int tiles = static_cast<int>(centres.size());
+
+		tile0 = static_cast<int>(std::upper_bound(centres.begin(), centres.end(), position) - centres.begin()) - 1;
+		if (tile0 < 0 || tile0 == tiles - 1) {
+			// Before the first or after the last centre only one tile contributes
+			tile0 = std::clamp(tile0, 0, tiles - 1);
+			tile1 = tile0;
+			weight = 0.0f;
+			return;
+		}
+
+		tile1 = tile0 + 1;
+		weight = (position - centres[tile0]) / (centres[tile1] - centres[tile0]);
+	}
+
+	/// <summary>
+	/// Clips histogram at limit and spreads clipped counts evenly over all bins.
+	/// </summary>
+	static void Clip(uint32_t* histogram, int bins, uint32_t limit)
+	{
+		uint64_t excess = 0;
+		for (int b = 0; b < bins; b++) {
+			if (histogram[b] > limit) {
+				excess += histogram[b] - limit;
+				histogram[b] = limit;
+			}
+		}
+
+		const uint32_t increment = static_cast<uint32_t>(excess / bins);
+		uint64_t remainder = excess % bins;
+
+		for (int b = 0; b < bins; b++) {
+			histogram[b] += increment;
+		}
+
+		// Remaining counts go to bins evenly spaced over whole range
+		const int step = std::max(1, static_cast<int>(bins / std::max<uint64_t>(remainder, 1)));
+		for (int b = 0; b < bins && remainder > 0; b += step, remainder--) {
+			histogram[b]++;
+		}
+	}
+
+	void Apply(
+		const float* source,
+		float* destination,
+		int width,
+		int height,
+		int tilesX,
+		int tilesY,
+		float clipLimit,
+		int bins
+	) {
+		if (width <= 0 || height <= 0) {
+			return;
+		}
+
+		tilesX = std::clamp(tilesX, 1, width);
+		tilesY = std::clamp(tilesY, 1, height);
+		bins = std::max(bins, 2);
+
+		const float scale = static_cast<float>(bins - 1);
+
+		// CDF of every tile (bins values each, tile of row ty and column tx is at ty * tilesX + tx)
+		std::vector<float> tables(static_cast<size_t>(tilesX) * tilesY * bins);
+
+		Utils::ParallelBands(tilesX * tilesY, [&](int begin, int end) {
+			std::vector<uint32_t> histogram(bins);
+
+			for (int tile = begin; tile < end; tile++) {
+				const int tx = tile % tilesX;
+				const int ty = tile / tilesX;
+				const int x0 = TileStart(tx, tilesX, width);
+				const int x1 = TileStart(tx + 1, tilesX, width);
+				const int y0 = TileStart(ty, tilesY, height);
+				const int y1 = TileStart(ty + 1, tilesY, height);
+				const uint32_t pixels = static_cast<uint32_t>(x1 - x0) * (y1 - y0);
+
+				std::fill(histogram.begin(), histogram.end(), 0);
+				for (int y = y0; y < y1; y++) {
+					const float* row = source + static_cast<size_t>(y) * width;
+					for (int x = x0; x < x1; x++) {
+						histogram[static_cast<int>(std::clamp(row[x], 0.0f, 1.0f) * scale + 0.5f)]++;
+					}
+				}
+
+				if (clipLimit > 0.0f) {
+					Clip(histogram.data(), bins, std::max(1u, static_cast<uint32_t>(clipLimit * pixels / bins)));
+				}
+
+				float* table = tables.data() + static_cast<size_t>(tile) * bins;
+				uint32_t sum = 0;
+				for (int b = 0; b < bins; b++) {
+					sum += histogram[b];
+					table[b] = static_cast<float>(sum) / pixels;
+				}
+			}
+		});
+
+		std::vector<float> centresX(tilesX);
+		std::vector<float> centresY(tilesY);
+		for (int tx = 0; tx < tilesX; tx++) {
+			centresX[tx] = 0.5f * (TileStart(tx, tilesX, width) + TileStart(tx + 1, tilesX, width));
+		}
+		for (int ty = 0; ty < tilesY; ty++) {
+			centresY[ty] = 0.5f * (TileStart(ty, tilesY, height) + TileStart(ty + 1, tilesY, height));
+		}
+
+		// Columns are split into segments with the same pair of tiles, weights along row are the same for all rows
+		std::vector<float> weightsX(width);
+		std::vector<Segment> segments;
+		for (int x = 0; x < width; x++) {
+			int tile0, tile1;
+			NearestTiles(centresX, x + 0.5f, tile0, tile1, weightsX[x]);
+
+			if (segments.empty() || segments.back().tile0 != tile0 || segments.back().tile1 != tile1) {
+				segments.push_back({ x, x, tile0, tile1 });
+			}
+			segments.back().end = x + 1;
+		}
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			const Simd::Float zero = Simd::zero();
+			const Simd::Float one = Simd::broadcast(1.0f);
+			const Simd::Float binScale = Simd::broadcast(scale);
+			const Simd::Float half = Simd::broadcast(0.5f);
+
+			for (int y = begin; y < end; y++) {
+				int tileY0, tileY1;
+				float weightY;
+				NearestTiles(centresY, y + 0.5f, tileY0, tileY1, weightY);
+
+				const Simd::Float weightYVector = Simd::broadcast(weightY);
+				const float* sourceRow = source + static_cast<size_t>(y) * width;
+				float* destinationRow = destination + static_cast<size_t>(y) * width;
+
+				for (const Segment& segment : segments) {
+					const float* table00 = tables.data() + (static_cast<size_t>(tileY0) * tilesX + segment.tile0) * bins;
+					const float* table01 = tables.data() + (static_cast<size_t>(tileY0) * tilesX + segment.tile1) * bins;
+					const float* table10 = tables.data() + (static_cast<size_t>(tileY1) * tilesX + segment.tile0) * bins;
+					const float* table11 = tables.data() + (static_cast<size_t>(tileY1) * tilesX + segment.tile1) * bins;
+
+					int x = segment.begin;
+					for (; x + Simd::width <= segment.end; x += Simd::width) {
+						// Clamped index is non-negative, truncation in lookup rounds it to nearest bin
+						Simd::Float value = Simd::max(Simd::min(Simd::load(sourceRow + x), one), zero);
+						Simd::Float bin = Simd::mulAdd(value, binScale, half);
+						Simd::Float weightX = Simd::load(weightsX.data() + x);
+
+						Simd::Float v00 = Simd::lookup(table00, bin);
+						Simd::Float v10 = Simd::lookup(table10, bin);
+						Simd::Float top = Simd::mulAdd(Simd::sub(Simd::lookup(table01, bin), v00), weightX, v00);
+						Simd::Float bottom = Simd::mulAdd(Simd::sub(Simd::lookup(table11, bin), v10), weightX, v10);
+
+						Simd::store(destinationRow + x, Simd::mulAdd(Simd::sub(bottom, top), weightYVector, top));
+					}
+					for (; x < segment.end; x++) {
+						const int bin = static_cast<int>(std::clamp(sourceRow[x], 0.0f, 1.0f) * scale + 0.5f);
+						const float weightX = weightsX[x];
+
+						const float top = table00[bin] + (table01[bin] - table00[bin]) * weightX;
+						const float bottom = table10[bin] + (table11[bin] - table10[bin]) * weightX;
+
+						destinationRow[x] = top + (bottom - top) * weightY;
+					}
+				}
+			}
+		});
+	}
+}
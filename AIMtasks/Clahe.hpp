@@ -0,0 +1,36 @@
+#pragma once
+
+/// <summary>
+/// Namespace with contrast limited adaptive histogram equalization (CLAHE) of grayscale float data in <0,1>.
+/// </summary>
+namespace Clahe
+{
+	/// <summary>
+	/// Equalizes every pixel by histogram of its neighbourhood instead of whole image.
+	///
+	/// Image is split into grid of tiles, histogram of every tile is clipped at clipLimit times its mean bin
+	/// count (clipped counts are spread over all bins, which limits amplification of noise in flat areas)
+	/// and turned into CDF. Pixel is mapped through CDFs of four nearest tiles (by their centres) and results
+	/// are bilinearly interpolated, pixels at image border use nearest tiles only. Tiles are counted
+	/// in parallel, interpolation runs over bands of rows Simd::width pixels at once.
+	/// Every pixel reads only its own value, so source and destination may be the same buffer.
+	/// </summary>
+	/// <param name="source">Input values in <0,1></param>
+	/// <param name="destination">Where to save equalized values</param>
+	/// <param name="width">Width of image</param>
+	/// <param name="height">Height of image</param>
+	/// <param name="tilesX">Number of tile columns</param>
+	/// <param name="tilesY">Number of tile rows</param>
+	/// <param name="clipLimit">Clip limit relative to mean bin count (e.g. 2 - 4), zero or negative disables clipping</param>
+	/// <param name="bins">Number of histogram bins, value v falls into bin round(v * (bins - 1))</param>
+	void Apply(
+		const float* source,
+		float* destination,
+		int width,
+		int height,
+		int tilesX,
+		int tilesY,
+		float clipLimit,
+		int bins = 256
+	);
+}
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <vector>
+
+#include "Color.hpp"
+#include "Pixel.hpp"
+#include "Simd.hpp"
+#include "Utils.hpp"
+
+namespace Color
+{
+	int Components(Layout layout)
+	{
+		return layout == Layout::RGBA ? 4 : 3;
+	}
+
+	int Planes(Space space)
+	{
+		return space == Space::LUMINANCE ? 1 : 3;
+	}
+
+	/// <summary>
+	/// Splits row of interleaved pixels into rows of components.
+	/// </summary>
+	template <int Components, bool Reversed>
+	static void SplitRow(const uint8_t* row, int width, float* r, float* g, float* b, float* a)
+	{
+		for (int x = 0; x < width; x++) {
+			const uint8_t* pixel = row + x * Components;
+
+			r[x] = pixel[Reversed ? 2 : 0] / 255.0f;
+			g[x] = pixel[1] / 255.0f;
+			b[x] = pixel[Reversed ? 0 : 2] / 255.0f;
+			if constexpr (Components == 4) {
+				a[x] = pixel[3] / 255.0f;
+			}
+		}
+	}
+
+	static void SplitRow(const uint8_t* row, Layout layout, int width, float* r, float* g, float* b, float* a)
+	{
+		switch (layout) {
+		case Layout::RGB:
+			SplitRow<3, false>(row, width, r, g, b, a);
+			break;
+		case Layout::RGBA:
+			SplitRow<4, false>(row, width, r, g, b, a);
+			break;
+		case Layout::BGR:
+			SplitRow<3, true>(row, width, r, g, b, a);
+			break;
+		}
+	}
+
+	/// <summary>
+	/// Merges rows of components into row of interleaved pixels.
+	/// </summary>
+	template <int Components, bool Reversed>
+	static void MergeRow(const float* r, const float* g, const float* b, const float* a, int width, uint8_t* row)
+	{
+		for (int x = 0; x < width; x++) {
+			uint8_t* pixel = row + x * Components;
+
+			pixel[Reversed ? 2 : 0] = Pixel::FromValue<uint8_t>(r[x]);
+			pixel[1] = Pixel::FromValue<uint8_t>(g[x]);
+			pixel[Reversed ? 0 : 2] = Pixel::FromValue<uint8_t>(b[x]);
+			if constexpr (Components == 4) {
+				pixel[3] = Pixel::FromValue<uint8_t>(a[x]);
+			}
+		}
+	}
+
+	static void MergeRow(const float* r, const float* g, const float* b, const float* a, Layout layout, int width, uint8_t* row)
+	{
+		switch (layout) {
+		case Layout::RGB:
+			MergeRow<3, false>(r, g, b, a, width, row);
+			break;
+		case Layout::RGBA:
+			MergeRow<4, false>(r, g, b, a, width, row);
+			break;
+		case Layout::BGR:
+			MergeRow<3, true>(r, g, b, a, width, row);
+			break;
+		}
+	}
+
+	// Conversions below process whole vectors, count is multiple of Simd::width
+
+	static void RGBToLuminance(const float* r, const float* g, const float* b, float* luminance, int count)
+	{
+		// Weights of Utils::luminanceFromRGB
+		const Simd::Float weightR = Simd::broadcast(0.2126f);
+		const Simd::Float weightG = Simd::broadcast(0.7152f);
+		const Simd::Float weightB = Simd::broadcast(0.0722f);
+
+		for (int x = 0; x < count; x += Simd::width) {
+			Simd::Float value = Simd::mul(Simd::load(r + x), weightR);
+			value = Simd::mulAdd(Simd::load(g + x), weightG, value);
+			value = Simd::mulAdd(Simd::load(b + x), weightB, value);
+
+			Simd::store(luminance + x, value);
+		}
+	}
+
+	/// <summary>
+	/// Converts RGB rows to Y, Cb and Cr rows in place.
+	/// </summary>
+	static void RGBToYCbCr(float* r, float* g, float* b, int count)
+	{
+		const Simd::Float weightR = Simd::broadcast(0.299f);
+		const Simd::Float weightG = Simd::broadcast(0.587f);
+		const Simd::Float weightB = Simd::broadcast(0.114f);
+		const Simd::Float scaleB = Simd::broadcast(1.0f / 1.772f);
+		const Simd::Float scaleR = Simd::broadcast(1.0f / 1.402f);
+		const Simd::Float half = Simd::broadcast(0.5f);
+
+		for (int x = 0; x < count; x += Simd::width) {
+			Simd::Float red = Simd::load(r + x);
+			Simd::Float blue = Simd::load(b + x);
+
+			Simd::Float luma = Simd::mul(red, weightR);
+			luma = Simd::mulAdd(Simd::load(g + x), weightG, luma);
+			luma = Simd::mulAdd(blue, weightB, luma);
+
+			Simd::store(r + x, luma);
+			Simd::store(g + x, Simd::mulAdd(Simd::sub(blue, luma), scaleB, half));
+			Simd::store(b + x, Simd::mulAdd(Simd::sub(red, luma), scaleR, half));
+		}
+	}
+
+	/// <summary>
+	/// Converts Y, Cb and Cr rows to RGB rows in place.
+	/// </summary>
+	static void YCbCrToRGB(float* y, float* cb, float* cr, int count)
+	{
+		const Simd::Float scaleR = Simd::broadcast(1.402f);
+		const Simd::Float scaleB = Simd::broadcast(1.772f);
+		const Simd::Float weightR = Simd::broadcast(-0.299f / 0.587f);
+		const Simd::Float weightB = Simd::broadcast(-0.114f / 0.587f);
+		const Simd::Float scaleY = Simd::broadcast(1.0f / 0.587f);
+		const Simd::Float half = Simd::broadcast(0.5f);
+
+		for (int x = 0; x < count; x += Simd::width) {
+			Simd::Float luma = Simd::load(y + x);
+
+			Simd::Float red = Simd::mulAdd(Simd::sub(Simd::load(cr + x), half), scaleR, luma);
+			Simd::Float blue = Simd::mulAdd(Simd::sub(Simd::load(cb + x), half), scaleB, luma);
+
+			// Green is what remains of luma
+			Simd::Float green = Simd::mul(luma, scaleY);
+			green = Simd::mulAdd(red, weightR, green);
+			green = Simd::mulAdd(blue, weightB, green);
+
+			Simd::store(y + x, red);
+			Simd::store(cb + x, green);
+			Simd::store(cr + x, blue);
+		}
+	}
+
+	/// <summary>
+	/// Selects a where mask (0 or 1 from Simd::lessEqual) is 1, otherwise b.
+	/// </summary>
+	static inline Simd::Float Select(Simd::Float mask, Simd::Float a, Simd::Float b)
+	{
+		return Simd::mulAdd(mask, Simd::sub(a, b), b);
+	}
+
+	/// <summary>
+	/// Converts RGB rows to H, S and V rows in place, hue sector is chosen by masks instead of branches.
+	/// </summary>
+	static void RGBToHSV(float* r, float* g, float* b, int count)
+	{
+		const Simd::Float zero = Simd::zero();
+		const Simd::Float one = Simd::broadcast(1.0f);
+		const Simd::Float two = Simd::broadcast(2.0f);
+		const Simd::Float four = Simd::broadcast(4.0f);
+		const Simd::Float sixth = Simd::broadcast(1.0f / 6.0f);
+		// Gray pixels have zero differences, so any positive divisor gives zero hue and saturation
+		const Simd::Float tiny = Simd::broadcast(1e-20f);
+
+		for (int x = 0; x < count; x += Simd::width) {
+			Simd::Float red = Simd::load(r + x);
+			Simd::Float green = Simd::load(g + x);
+			Simd::Float blue = Simd::load(b + x);
+
+			Simd::Float maximum = Simd::max(Simd::max(red, green), blue);
+			Simd::Float minimum = Simd::min(Simd::min(red, green), blue);
+			Simd::Float delta = Simd::sub(maximum, minimum);
+			Simd::Float divisor = Simd::max(delta, tiny);
+
+			Simd::Float hueR = Simd::div(Simd::sub(green, blue), divisor);
+			Simd::Float hueG = Simd::add(two, Simd::div(Simd::sub(blue, red), divisor));
+			Simd::Float hueB = Simd::add(four, Simd::div(Simd::sub(red, green), divisor));
+
+			// Red wins ties, then green
+			Simd::Float hue = Select(Simd::lessEqual(maximum, green), hueG, hueB);
+			hue = Select(Simd::lessEqual(maximum, red), hueR, hue);
+			hue = Simd::mul(hue, sixth);
+			// Negative hue of red sector wraps around
+			hue = Simd::add(hue, Simd::sub(one, Simd::lessEqual(zero, hue)));
+
+			Simd::store(r + x, hue);
+			Simd::store(g + x, Simd::div(delta, Simd::max(maximum, tiny)));
+			Simd::store(b + x, maximum);
+		}
+	}
+
+	/// <summary>
+	/// Converts H, S and V rows to RGB rows in place, component n (5 - red, 3 - green, 1 - blue) is
+	/// v - v * s * clamp(min(k, 4 - k), 0, 1) with k = (n + 6 * h) mod 6, which needs no sector branches.
+	/// </summary>
+	static void HSVToRGB(float* h, float* s, float* v, int count)
+	{
+		const Simd::Float zero = Simd::zero();
+		const Simd::Float one = Simd::broadcast(1.0f);
+		const Simd::Float four = Simd::broadcast(4.0f);
+		const Simd::Float six = Simd::broadcast(6.0f);
+		const Simd::Float sixth = Simd::broadcast(1.0f / 6.0f);
+		const Simd::Float offsets[3] = { Simd::broadcast(5.0f), Simd::broadcast(3.0f), Simd::broadcast(1.0f) };
+
+		for (int x = 0; x < count; x += Simd::width) {
+			Simd::Float hue = Simd::mul(Simd::load(h + x), six);
+			Simd::Float value = Simd::load(v + x);
+			Simd::Float chroma = Simd::mul(value, Simd::load(s + x));
+
+			Simd::Float components[3];
+			for (int c = 0; c < 3; c++) {
+				Simd::Float k = Simd::add(offsets[c], hue);
+				k = Simd::sub(k, Simd::mul(six, Simd::floor(Simd::mul(k, sixth))));
+
+				Simd::Float weight = Simd::max(Simd::min(Simd::min(k, Simd::sub(four, k)), one), zero);
+				components[c] = Simd::sub(value, Simd::mul(chroma, weight));
+			}
+
+			Simd::store(h + x, components[0]);
+			Simd::store(s + x, components[1]);
+			Simd::store(v + x, components[2]);
+		}
+	}
+
+	void Decode(const uint8_t* source, Layout layout, int width, int height, Space space, float* planes, float* alpha)
+	{
+		const int components = Components(layout);
+		const int padded = (width + Simd::width - 1) / Simd::width * Simd::width;
+		const size_t planeSize = static_cast<size_t>(width) * height;
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			// Rows are padded to whole vectors, padding is never written by split and stays zero
+			std::vector<float> buffers(4 * static_cast<size_t>(padded), 0.0f);
+			float* r = buffers.data();
+			float* g = r + padded;
+			float* b = g + padded;
+			float* a = b + padded;
+
+			for (int y = begin; y < end; y++) {
+				const uint8_t* row = source + static_cast<size_t>(y) * width * components;
+				const size_t offset = static_cast<size_t>(y) * width;
+				float* alphaRow = alpha != nullptr ? alpha + offset : a;
+
+				if (space == Space::RGB) {
+					// Components are final, so they are split directly to planes
+					SplitRow(row, layout, width, planes + offset, planes + planeSize + offset, planes + 2 * planeSize + offset, alphaRow);
+					continue;
+				}
+
+				SplitRow(row, layout, width, r, g, b, alphaRow);
+
+				if (space == Space::LUMINANCE) {
+					RGBToLuminance(r, g, b, r, padded);
+					std::copy(r, r + width, planes + offset);
+					continue;
+				}
+
+				if (space == Space::YCBCR) {
+					RGBToYCbCr(r, g, b, padded);
+				} else {
+					RGBToHSV(r, g, b, padded);
+				}
+
+				std::copy(r, r + width, planes + offset);
+				std::copy(g, g + width, planes + planeSize + offset);
+				std::copy(b, b + width, planes + 2 * planeSize + offset);
+			}
+		});
+	}
+
+	void Encode(const float* planes, Space space, int width, int height, Layout layout, uint8_t* destination, const float* alpha)
+	{
+		const int components = Components(layout);
+		const int padded = (width + Simd::width - 1) / Simd::width * Simd::width;
+		const size_t planeSize = static_cast<size_t>(width) * height;
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			std::vector<float> buffers(3 * static_cast<size_t>(padded), 0.0f);
+			float* c0 = buffers.data();
+			float* c1 = c0 + padded;
+			float* c2 = c1 + padded;
+
+			// Missing alpha is read from row of ones
+			std::vector<float> opaque(layout == Layout::RGBA && alpha == nullptr ? width : 0, 1.0f);
+
+			for (int y = begin; y < end; y++) {
+				uint8_t* row = destination + static_cast<size_t>(y) * width * components;
+				const size_t offset = static_cast<size_t>(y) * width;
+				const float* alphaRow = alpha != nullptr ? alpha + offset : opaque.data();
+
+				if (space == Space::RGB) {
+					MergeRow(planes + offset, planes + planeSize + offset, planes + 2 * planeSize + offset, alphaRow, layout, width, row);
+					continue;
+				}
+				if (space == Space::LUMINANCE) {
+					const float* luminance = planes + offset;
+					MergeRow(luminance, luminance, luminance, alphaRow, layout, width, row);
+					continue;
+				}
+
+				std::copy(planes + offset, planes + offset + width, c0);
+				std::copy(planes + planeSize + offset, planes + planeSize + offset + width, c1);
+				std::copy(planes + 2 * planeSize + offset, planes + 2 * planeSize + offset + width, c2);
+
+				if (space == Space::YCBCR) {
+					YCbCrToRGB(c0, c1, c2, padded);
+				} else {
+					HSVToRGB(c0, c1, c2, padded);
+				}
+
+				MergeRow(c0, c1, c2, alphaRow, layout, width, row);
+			}
+		});
+	}
+}
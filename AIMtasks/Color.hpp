@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+/// <summary>
+/// Namespace with conversion of interleaved 8-bit colour pixels to planes of float values in <0,1> of given
+/// colour space and back.
+///
+/// Rows are processed in bands in parallel. Every row is first split into planes of R, G and B (loops simple
+/// enough to be vectorized by compiler), then converted Simd::width pixels at once while it is still in cache.
+/// </summary>
+namespace Color
+{
+	/// <summary>
+	/// Order of components of interleaved 8-bit pixels.
+	/// </summary>
+	enum class Layout {
+		RGB,
+		RGBA,
+		BGR
+	};
+
+	/// <summary>
+	/// Colour space of planes, all components are in <0,1>.
+	///
+	/// LUMINANCE is single plane weighted as Utils::luminanceFromRGB, YCBCR is full range BT.601 of JPEG
+	/// (chroma centred at 0.5), HSV has hue as fraction of full turn (0 for gray pixels).
+	/// </summary>
+	enum class Space {
+		LUMINANCE,
+		RGB,
+		YCBCR,
+		HSV
+	};
+
+	/// <summary>
+	/// Number of components of pixel of layout.
+	/// </summary>
+	int Components(Layout layout);
+
+	/// <summary>
+	/// Number of planes of space (without alpha).
+	/// </summary>
+	int Planes(Space space);
+
+	/// <summary>
+	/// Converts interleaved 8-bit pixels to planes of given space.
+	/// </summary>
+	/// <param name="source">Pixels in rows, Components(layout) values each</param>
+	/// <param name="layout">Order of components</param>
+	/// <param name="width">Width of image</param>
+	/// <param name="height">Height of image</param>
+	/// <param name="space">Colour space of planes</param>
+	/// <param name="planes">Where to save Planes(space) planes of width * height values one after another</param>
+	/// <param name="alpha">Where to save alpha plane (only RGBA), nullptr drops alpha</param>
+	void Decode(const uint8_t* source, Layout layout, int width, int height, Space space, float* planes, float* alpha = nullptr);
+
+	/// <summary>
+	/// Converts planes of given space to interleaved 8-bit pixels, values are clamped to <0,1> and rounded to
+	/// nearest code. Luminance is written to all colour components.
+	/// </summary>
+	/// <param name="planes">Planes(space) planes of width * height values one after another</param>
+	/// <param name="space">Colour space of planes</param>
+	/// <param name="width">Width of image</param>
+	/// <param name="height">Height of image</param>
+	/// <param name="layout">Order of components</param>
+	/// <param name="destination">Where to save pixels in rows, Components(layout) values each</param>
+	/// <param name="alpha">Alpha plane (only RGBA), nullptr makes pixels opaque</param>
+	void Encode(const float* planes, Space space, int width, int height, Layout layout, uint8_t* destination, const float* alpha = nullptr);
+}
@@ -0,0 +1,760 @@
+#include <algorithm>
+#include <cmath>
+
+#include <fftw3.h>
+
+#include "Convolution.hpp"
+#include "FFTPlans.hpp"
+#include "ImageBuffer.hpp"
+#include "Simd.hpp"
+#include "Utils.hpp"
+
+namespace Convolution
+{
+	/// <summary>
+	/// Computes single pixel of row convolution with clamping (used for border strips).
+	/// </summary>
+	static inline float ClampedRowPixel(const float* row, int x, int width, const float* taps, int kernelSize)
+	{
+		int center = kernelSize / 2;
+		float value = 0.0f;
+
+		for (int i = 0; i < kernelSize; i++) {
+			value += row[std::clamp(x + i - center, 0, width - 1)] * taps[i];
+		}
+
+		return value;
+	}
+
+	void HorizontalPass(const float* source, float* destination, int width, int height, const std::vector<float>& taps)
+	{
+		const int kernelSize = static_cast<int>(taps.size());
+		const int center = kernelSize / 2;
+		const float* k = taps.data();
+
+		// Interior is <center, width - center), it is empty for kernels wider than image
+		const int interiorBegin = std::min(center, width);
+		const int interiorEnd = std::max(interiorBegin, width - center);
+
+		Utils::ParallelBands(height, [=](int begin, int end) {
+			for (int y = begin; y < end; y++) {
+				const float* in = source + static_cast<size_t>(y) * width;
+				float* out = destination + static_cast<size_t>(y) * width;
+
+				for (int x = 0; x < interiorBegin; x++) {
+					out[x] = ClampedRowPixel(in, x, width, k, kernelSize);
+				}
+
+				// Four independent accumulators hide latency of multiply-add chain
+				int x = interiorBegin;
+				for (; x + 4 * Simd::width <= interiorEnd; x += 4 * Simd::width) {
+					const float* window = in + x - center;
+					Simd::Float sum0 = Simd::zero();
+					Simd::Float sum1 = Simd::zero();
+					Simd::Float sum2 = Simd::zero();
+					Simd::Float sum3 = Simd::zero();
+
+					for (int i = 0; i < kernelSize; i++) {
+						const Simd::Float weight = Simd::broadcast(k[i]);
+						sum0 = Simd::mulAdd(Simd::load(window + i), weight, sum0);
+						sum1 = Simd::mulAdd(Simd::load(window + i + Simd::width), weight, sum1);
+						sum2 = Simd::mulAdd(Simd::load(window + i + 2 * Simd::width), weight, sum2);
+						sum3 = Simd::mulAdd(Simd::load(window + i + 3 * Simd::width), weight, sum3);
+					}
+
+					Simd::store(out + x, sum0);
+					Simd::store(out + x + Simd::width, sum1);
+					Simd::store(out + x + 2 * Simd::width, sum2);
+					Simd::store(out + x + 3 * Simd::width, sum3);
+				}
+
+				for (; x + Simd::width <= interiorEnd; x += Simd::width) {
+					const float* window = in + x - center;
+					Simd::Float sum = Simd::zero();
+
+					for (int i = 0; i < kernelSize; i++) {
+						sum = Simd::mulAdd(Simd::load(window + i), Simd::broadcast(k[i]), sum);
+					}
+
+					Simd::store(out + x, sum);
+				}
+
+				for (; x < interiorEnd; x++) {
+					const float* window = in + x - center;
+					float sum = 0.0f;
+
+					for (int i = 0; i < kernelSize; i++) {
+						sum += window[i] * k[i];
+					}
+
+					out[x] = sum;
+				}
+
+				for (x = interiorEnd; x < width; x++) {
+					out[x] = ClampedRowPixel(in, x, width, k, kernelSize);
+				}
+			}
+		});
+	}
+
+	/// <summary>
+	/// Computes pixels <xBegin, xEnd) of one output row of vertical convolution from source rows under kernel.
+	/// </summary>
+	static inline void AccumulateRows(const float* const* rows, const float* k, int kernelSize, float* out, int xBegin, int xEnd)
+	{
+		int x = xBegin;
+		for (; x + 4 * Simd::width <= xEnd; x += 4 * Simd::width) {
+			Simd::Float sum0 = Simd::zero();
+			Simd::Float sum1 = Simd::zero();
+			Simd::Float sum2 = Simd::zero();
+			Simd::Float sum3 = Simd::zero();
+
+			for (int i = 0; i < kernelSize; i++) {
+				const float* in = rows[i] + x;
+				const Simd::Float weight = Simd::broadcast(k[i]);
+				sum0 = Simd::mulAdd(Simd::load(in), weight, sum0);
+				sum1 = Simd::mulAdd(Simd::load(in + Simd::width), weight, sum1);
+				sum2 = Simd::mulAdd(Simd::load(in + 2 * Simd::width), weight, sum2);
+				sum3 = Simd::mulAdd(Simd::load(in + 3 * Simd::width), weight, sum3);
+			}
+
+			Simd::store(out + x, sum0);
+			Simd::store(out + x + Simd::width, sum1);
+			Simd::store(out + x + 2 * Simd::width, sum2);
+			Simd::store(out + x + 3 * Simd::width, sum3);
+		}
+
+		for (; x + Simd::width <= xEnd; x += Simd::width) {
+			Simd::Float sum = Simd::zero();
+
+			for (int i = 0; i < kernelSize; i++) {
+				sum = Simd::mulAdd(Simd::load(rows[i] + x), Simd::broadcast(k[i]), sum);
+			}
+
+			Simd::store(out + x, sum);
+		}
+
+		for (; x < xEnd; x++) {
+			float sum = 0.0f;
+
+			for (int i = 0; i < kernelSize; i++) {
+				sum += rows[i][x] * k[i];
+			}
+
+			out[x] = sum;
+		}
+	}
+
+	/// <summary>
+	/// Computes pixels <xBegin, xEnd) of four consecutive output rows of vertical convolution at once.
+	/// Every loaded source vector contributes to all four rows, which cuts loads almost four times.
+	/// </summary>
+	/// <param name="rows">Source rows under kernel of first output row followed by three more rows</param>
+	/// <param name="paddedK">Kernel with three zeros on both sides, so that row r uses paddedK[j - r + 3] branch-free</param>
+	static inline void AccumulateFourRows(const float* const* rows, const float* paddedK, int kernelSize, float* const* out, int xBegin, int xEnd)
+	{
+		const float* k = paddedK + 3;
+
+		int x = xBegin;
+		for (; x + 2 * Simd::width <= xEnd; x += 2 * Simd::width) {
+			Simd::Float sum00 = Simd::zero(), sum01 = Simd::zero();
+			Simd::Float sum10 = Simd::zero(), sum11 = Simd::zero();
+			Simd::Float sum20 = Simd::zero(), sum21 = Simd::zero();
+			Simd::Float sum30 = Simd::zero(), sum31 = Simd::zero();
+
+			// Source row j is tap (j - r) of output row r
+			for (int j = 0; j < kernelSize + 3; j++) {
+				const Simd::Float in0 = Simd::load(rows[j] + x);
+				const Simd::Float in1 = Simd::load(rows[j] + x + Simd::width);
+
+				const Simd::Float weight0 = Simd::broadcast(k[j]);
+				const Simd::Float weight1 = Simd::broadcast(k[j - 1]);
+				const Simd::Float weight2 = Simd::broadcast(k[j - 2]);
+				const Simd::Float weight3 = Simd::broadcast(k[j - 3]);
+
+				sum00 = Simd::mulAdd(in0, weight0, sum00);
+				sum01 = Simd::mulAdd(in1, weight0, sum01);
+				sum10 = Simd::mulAdd(in0, weight1, sum10);
+				sum11 = Simd::mulAdd(in1, weight1, sum11);
+				sum20 = Simd::mulAdd(in0, weight2, sum20);
+				sum21 = Simd::mulAdd(in1, weight2, sum21);
+				sum30 = Simd::mulAdd(in0, weight3, sum30);
+				sum31 = Simd::mulAdd(in1, weight3, sum31);
+			}
+
+			Simd::store(out[0] + x, sum00);
+			Simd::store(out[0] + x + Simd::width, sum01);
+			Simd::store(out[1] + x, sum10);
+			Simd::store(out[1] + x + Simd::width, sum11);
+			Simd::store(out[2] + x, sum20);
+			Simd::store(out[2] + x + Simd::width, sum21);
+			Simd::store(out[3] + x, sum30);
+			Simd::store(out[3] + x + Simd::width, sum31);
+		}
+
+		if (x < xEnd) {
+			for (int r = 0; r < 4; r++) {
+				AccumulateRows(rows + r, k, kernelSize, out[r], x, xEnd);
+			}
+		}
+	}
+
+	int VerticalStripWidth(int width, int kernelSize)
+	{
+		// Rows under kernel (and output row) of one strip should stay in L2 cache
+		constexpr int cacheBytes = 512 * 1024;
+		constexpr int block = 4 * Simd::width;
+
+		int stripWidth = cacheBytes / (static_cast<int>(sizeof(float)) * (kernelSize + 1));
+		stripWidth = std::max(block, stripWidth / block * block);
+
+		return std::min(stripWidth, width);
+	}
+
+	void VerticalPass(
+		const float* source,
+		float* destination,
+		int width,
+		int height,
+		const std::vector<float>& taps,
+		VerticalStrategy strategy
+	) {
+		const int kernelSize = static_cast<int>(taps.size());
+		const int center = kernelSize / 2;
+		const float* k = taps.data();
+
+		std::vector<float> paddedTaps(kernelSize + 6, 0.0f);
+		std::copy(taps.begin(), taps.end(), paddedTaps.begin() + 3);
+		const float* paddedK = paddedTaps.data();
+
+		const int stripWidth = strategy == VerticalStrategy::ColumnStrips ? VerticalStripWidth(width, kernelSize) : width;
+		// When whole rows under kernel fit into cache, copying them into ring would be just overhead
+		const bool useRing = stripWidth < width;
+
+		Utils::ParallelBands(height, [=](int begin, int end) {
+			// Source rows under kernel (of four output rows), clamped to image so no pixel needs border handling
+			std::vector<const float*> rows(kernelSize + 3);
+			float* out[4];
+
+			// Ring of row segments of current strip; rows of image are often power of two apart and would
+			// compete for the same cache sets, copies in ring have padded stride and stay cached
+			const int ringRows = kernelSize + 3;
+			const int ringStride = (stripWidth + 15) / 16 * 16 + 16;
+			std::vector<float> ring(useRing ? static_cast<size_t>(ringRows) * ringStride : 0);
+
+			for (int stripBegin = 0; stripBegin < width; stripBegin += stripWidth) {
+				const int stripLength = std::min(width - stripBegin, stripWidth);
+
+				// Absolute index (relative to first row under kernel of band) of next row to copy into ring
+				int nextRing = 0;
+
+				for (int y = begin; y < end; y += 4) {
+					for (int r = 0; r < 4; r++) {
+						out[r] = destination + static_cast<size_t>(std::min(y + r, end - 1)) * width + stripBegin;
+					}
+
+					if (useRing) {
+						// Strip is processed over all rows of band before moving to next one, so while sliding
+						// down only new row segments are fetched from memory, the rest is reused from ring
+						for (; nextRing < y - begin + ringRows; nextRing++) {
+							int sourceRow = std::clamp(begin - center + nextRing, 0, height - 1);
+							std::copy_n(
+								source + static_cast<size_t>(sourceRow) * width + stripBegin,
+								stripLength,
+								ring.data() + static_cast<size_t>(nextRing % ringRows) * ringStride
+							);
+						}
+
+						for (int i = 0; i < ringRows; i++) {
+							rows[i] = ring.data() + static_cast<size_t>((y - begin + i) % ringRows) * ringStride;
+						}
+					} else {
+						for (int i = 0; i < ringRows; i++) {
+							rows[i] = source + static_cast<size_t>(std::clamp(y + i - center, 0, height - 1)) * width + stripBegin;
+						}
+					}
+
+					if (y + 4 <= end) {
+						AccumulateFourRows(rows.data(), paddedK, kernelSize, out, 0, stripLength);
+					} else {
+						for (int r = 0; y + r < end; r++) {
+							AccumulateRows(rows.data() + r, k, kernelSize, out[r], 0, stripLength);
+						}
+					}
+				}
+			}
+		});
+	}
+
+	void Direct(
+		const float* source,
+		float* destination,
+		int width,
+		int height,
+		const std::vector<float>& kernel,
+		int kernelSize
+	) {
+		const int center = kernelSize / 2;
+
+		// Apron of kernel radius replaces clamping of coordinates of every tap
+		const ImageBuffer padded(source, width, height, center);
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			float result[Simd::width];
+
+			for (int y = begin; y < end; y++) {
+				float* destinationRow = destination + static_cast<size_t>(y) * width;
+
+				for (int x = 0; x < width; x += Simd::width) {
+					Simd::Float sum = Simd::zero();
+
+					for (int kY = 0; kY < kernelSize; kY++) {
+						const float* row = padded.row(y + (kY - center)) + x - center;
+						const float* kernelRow = kernel.data() + kY * kernelSize;
+
+						for (int kX = 0; kX < kernelSize; kX++) {
+							sum = Simd::mulAdd(Simd::load(row + kX), Simd::broadcast(kernelRow[kX]), sum);
+						}
+					}
+
+					// Lanes behind end of row were computed from padding, they are not stored
+					Simd::store(result, sum);
+					std::copy(result, result + std::min(Simd::width, width - x), destinationRow + x);
+				}
+			}
+		});
+	}
+
+	void Separable(
+		const std::vector<float>& source,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		const std::vector<float>& xTaps,
+		const std::vector<float>& yTaps
+	) {
+		destination.resize(source.size());
+		Separable(source.data(), destination.data(), width, height, xTaps, yTaps);
+	}
+
+	void Separable(
+		const float* source,
+		float* destination,
+		int width,
+		int height,
+		const std::vector<float>& xTaps,
+		const std::vector<float>& yTaps
+	) {
+		std::vector<float> tmpData(static_cast<size_t>(width) * height);
+
+		HorizontalPass(source, tmpData.data(), width, height, xTaps);
+		VerticalPass(tmpData.data(), destination, width, height, yTaps);
+	}
+
+	void Box(const float* source, float* destination, int width, int height, int radius)
+	{
+		// Horizontal window sums, running sum is updated by pixel entering and leaving window
+		std::vector<float> rowSums(static_cast<size_t>(width) * height);
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			for (int y = begin; y < end; y++) {
+				const float* row = source + static_cast<size_t>(y) * width;
+				float* sums = rowSums.data() + static_cast<size_t>(y) * width;
+
+				double sum = 0.0;
+				for (int i = -radius; i <= radius; i++) {
+					sum += row[std::clamp(i, 0, width - 1)];
+				}
+
+				for (int x = 0; x < width; x++) {
+					sums[x] = static_cast<float>(sum);
+					sum += row[std::min(x + radius + 1, width - 1)] - row[std::max(x - radius, 0)];
+				}
+			}
+		});
+
+		// Vertical window sums of whole rows, each band starts its own running sums
+		const double normalization = 1.0 / ((2.0 * radius + 1.0) * (2.0 * radius + 1.0));
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			std::vector<double> sums(width, 0.0);
+
+			for (int i = begin - radius; i <= begin + radius; i++) {
+				const float* row = rowSums.data() + static_cast<size_t>(std::clamp(i, 0, height - 1)) * width;
+				for (int x = 0; x < width; x++) {
+					sums[x] += row[x];
+				}
+			}
+
+			for (int y = begin; y < end; y++) {
+				const float* entering = rowSums.data() + static_cast<size_t>(std::min(y + radius + 1, height - 1)) * width;
+				const float* leaving = rowSums.data() + static_cast<size_t>(std::max(y - radius, 0)) * width;
+				float* out = destination + static_cast<size_t>(y) * width;
+
+				for (int x = 0; x < width; x++) {
+					out[x] = static_cast<float>(sums[x] * normalization);
+					sums[x] += entering[x] - leaving[x];
+				}
+			}
+		});
+	}
+
+	RecursiveGaussCoefficients ComputeRecursiveGaussCoefficients(float sigma)
+	{
+		// Young, van Vliet: Recursive implementation of the Gaussian filter (1995)
+		double s = std::max(0.5, (double)sigma);
+		double q = s >= 2.5 ? 0.98711 * s - 0.96330 : 3.97156 - 4.14554 * sqrt(1.0 - 0.26891 * s);
+
+		double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+		double b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+		double b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+		double b3 = 0.422205 * q * q * q;
+
+		RecursiveGaussCoefficients coefficients;
+		coefficients.b1 = b1 / b0;
+		coefficients.b2 = b2 / b0;
+		coefficients.b3 = b3 / b0;
+		coefficients.B = 1.0 - (b1 + b2 + b3) / b0;
+		// Causal response has long tail, after this many samples behind border it is negligible
+		coefficients.extension = static_cast<int>(ceil(6.0 * s)) + 3;
+
+		return coefficients;
+	}
+
+	void RecursiveGaussHorizontal(const float* source, float* destination, int width, int height, float sigma)
+	{
+		const RecursiveGaussCoefficients c = ComputeRecursiveGaussCoefficients(sigma);
+		const int length = width + c.extension;
+
+		// Recursion along a row is serial, so groups of rows are transposed into buffer where the same
+		// step of all rows is contiguous and runs vectorized (like columns in vertical pass)
+		constexpr int group = 16;
+		const int groupCount = (height + group - 1) / group;
+
+		Utils::ParallelBands(groupCount, [=](int begin, int end) {
+			std::vector<double> lines(static_cast<size_t>(length) * group);
+			double s1[group], s2[group], s3[group];
+
+			for (int g = begin; g < end; g++) {
+				const int y0 = g * group;
+				const int rowCount = std::min(group, height - y0);
+
+				// Image continues by border pixel behind both ends of row, rows behind last one are
+				// duplicates and only keep the loops uniform
+				for (int r = 0; r < group; r++) {
+					const float* in = source + static_cast<size_t>(y0 + std::min(r, rowCount - 1)) * width;
+
+					for (int x = 0; x < length; x++) {
+						lines[static_cast<size_t>(x) * group + r] = in[std::min(x, width - 1)];
+					}
+				}
+
+				// Causal pass, steady state of left border pixel as initial condition
+				for (int r = 0; r < group; r++) {
+					s1[r] = s2[r] = s3[r] = lines[r];
+				}
+				for (int x = 0; x < length; x++) {
+					double* line = lines.data() + static_cast<size_t>(x) * group;
+
+					for (int r = 0; r < group; r++) {
+						double w = c.B * line[r] + c.b1 * s1[r] + c.b2 * s2[r] + c.b3 * s3[r];
+						line[r] = w;
+						s3[r] = s2[r];
+						s2[r] = s1[r];
+						s1[r] = w;
+					}
+				}
+
+				// Anti-causal pass starts far enough behind the border to have settled
+				for (int r = 0; r < group; r++) {
+					s2[r] = s3[r] = s1[r];
+				}
+				for (int x = length - 1; x >= 0; x--) {
+					double* line = lines.data() + static_cast<size_t>(x) * group;
+
+					for (int r = 0; r < group; r++) {
+						double v = c.B * line[r] + c.b1 * s1[r] + c.b2 * s2[r] + c.b3 * s3[r];
+						line[r] = v;
+						s3[r] = s2[r];
+						s2[r] = s1[r];
+						s1[r] = v;
+					}
+				}
+
+				for (int r = 0; r < rowCount; r++) {
+					float* out = destination + static_cast<size_t>(y0 + r) * width;
+
+					for (int x = 0; x < width; x++) {
+						out[x] = static_cast<float>(lines[static_cast<size_t>(x) * group + r]);
+					}
+				}
+			}
+		});
+	}
+
+	void RecursiveGaussVertical(const float* source, float* destination, int width, int height, float sigma)
+	{
+		const RecursiveGaussCoefficients c = ComputeRecursiveGaussCoefficients(sigma);
+		const int length = height + c.extension;
+
+		// Columns are independent, recursion runs over strips of columns and the inner loops over
+		// neighbouring columns are vectorized by compiler
+		constexpr int stripWidth = 256;
+		const int stripCount = (width + stripWidth - 1) / stripWidth;
+
+		Utils::ParallelBands(stripCount, [=](int begin, int end) {
+			// Three previous outputs of every column (double, poles are close to 1 for large sigma
+			// and float state would accumulate visible error) and causal outputs behind bottom border
+			std::vector<double> state(3 * stripWidth);
+			std::vector<float> extension(static_cast<size_t>(c.extension) * stripWidth);
+
+			for (int strip = begin; strip < end; strip++) {
+				const int x0 = strip * stripWidth;
+				const int stripLength = std::min(stripWidth, width - x0);
+
+				auto rowIn = [&](int y) {
+					return source + static_cast<size_t>(std::min(y, height - 1)) * width + x0;
+				};
+				auto rowOut = [&](int y) {
+					return y < height ? destination + static_cast<size_t>(y) * width + x0 : extension.data() + static_cast<size_t>(y - height) * stripWidth;
+				};
+
+				// Causal pass, steady state of top border pixel as initial condition
+				double* s1 = state.data();
+				double* s2 = s1 + stripWidth;
+				double* s3 = s2 + stripWidth;
+				for (int i = 0; i < 3; i++) {
+					std::copy_n(rowIn(0), stripLength, state.data() + i * stripWidth);
+				}
+
+				for (int y = 0; y < length; y++) {
+					const float* in = rowIn(y);
+					float* out = rowOut(y);
+
+					for (int x = 0; x < stripLength; x++) {
+						double w = c.B * in[x] + c.b1 * s1[x] + c.b2 * s2[x] + c.b3 * s3[x];
+						out[x] = static_cast<float>(w);
+						s3[x] = w;
+					}
+
+					// Oldest state was overwritten by newest output, rotate roles
+					std::swap(s3, s2);
+					std::swap(s2, s1);
+				}
+
+				// Anti-causal pass in place, starting with steady state of last causal output
+				std::copy_n(s1, stripLength, s2);
+				std::copy_n(s1, stripLength, s3);
+
+				for (int y = length - 1; y >= 0; y--) {
+					float* out = rowOut(y);
+
+					for (int x = 0; x < stripLength; x++) {
+						double v = c.B * out[x] + c.b1 * s1[x] + c.b2 * s2[x] + c.b3 * s3[x];
+						out[x] = static_cast<float>(v);
+						s3[x] = v;
+					}
+
+					std::swap(s3, s2);
+					std::swap(s2, s1);
+				}
+			}
+		});
+	}
+
+	void RecursiveGauss(const std::vector<float>& source, std::vector<float>& destination, int width, int height, float sigma)
+	{
+		destination.resize(source.size());
+		RecursiveGauss(source.data(), destination.data(), width, height, sigma);
+	}
+
+	void RecursiveGauss(const float* source, float* destination, int width, int height, float sigma)
+	{
+		std::vector<float> tmpData(static_cast<size_t>(width) * height);
+
+		RecursiveGaussHorizontal(source, tmpData.data(), width, height, sigma);
+		RecursiveGaussVertical(tmpData.data(), destination, width, height, sigma);
+	}
+
+	/// <summary>
+	/// Transform work (N^2 log N^2 of every tile) per output pixel for given tile size.
+	/// </summary>
+	static double FFTWork(int size, int kernelSize, int width, int height)
+	{
+		int valid = size - kernelSize + 1;
+		double tiles = (double)((width + valid - 1) / valid) * ((height + valid - 1) / valid);
+
+		return tiles * size * size * log2((double)size * size) / ((double)width * height);
+	}
+
+	int FFTTileSize(int kernelSize, int width, int height)
+	{
+		// There is no point in tiles larger than whole image with apron
+		const int limit = std::max(width, height) + kernelSize - 1;
+		int bestSize = 0;
+		double bestWork = 0.0;
+
+		// Sizes FFTW handles best (2^n and 3 * 2^n)
+		for (int power = 8; power <= (1 << 15); power *= 2) {
+			for (int size : { power, 3 * power / 2 }) {
+				if (size - kernelSize + 1 < 1) {
+					continue;
+				}
+
+				double work = FFTWork(size, kernelSize, width, height);
+				if (bestSize == 0 || work < bestWork) {
+					bestSize = size;
+					bestWork = work;
+				}
+
+				if (size >= limit) {
+					return bestSize;
+				}
+			}
+		}
+
+		return bestSize;
+	}
+
+	double EstimateCost(Algorithm algorithm, int kernelSize, int width, int height)
+	{
+		// Constants calibrated by aim_bench (ns per tap or per butterfly work unit)
+		constexpr double directTap = 0.9;
+		constexpr double separableTap = 0.06;
+		constexpr double separablePixel = 1.0;
+		constexpr double fftWork = 0.28;
+		constexpr double fftPixel = 3.0;
+
+		switch (algorithm) {
+		case Algorithm::Direct:
+			return directTap * kernelSize * kernelSize;
+		case Algorithm::Separable:
+			return separablePixel + separableTap * 2.0 * kernelSize;
+		case Algorithm::FFT:
+			// Forward and inverse transform of tiles, copies and spectrum product are part of per pixel cost
+			return fftPixel + fftWork * 2.0 * FFTWork(FFTTileSize(kernelSize, width, height), kernelSize, width, height);
+		}
+
+		return 0.0;
+	}
+
+	Algorithm ChooseAlgorithm(int kernelSize, bool separable, int width, int height)
+	{
+		Algorithm best = Algorithm::Direct;
+
+		for (Algorithm algorithm : { Algorithm::Separable, Algorithm::FFT }) {
+			if (algorithm == Algorithm::Separable && !separable) {
+				continue;
+			}
+
+			if (EstimateCost(algorithm, kernelSize, width, height) < EstimateCost(best, kernelSize, width, height)) {
+				best = algorithm;
+			}
+		}
+
+		return best;
+	}
+
+	void FFT(
+		const std::vector<float>& source,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		const std::vector<float>& kernel,
+		int kernelSize
+	) {
+		destination.resize(source.size());
+		FFT(source.data(), destination.data(), width, height, kernel, kernelSize);
+	}
+
+	void FFT(
+		const float* source,
+		float* destination,
+		int width,
+		int height,
+		const std::vector<float>& kernel,
+		int kernelSize
+	) {
+		const int center = kernelSize / 2;
+		const int size = FFTTileSize(kernelSize, width, height);
+		const int valid = size - kernelSize + 1;
+		// Real to complex transform stores only non-redundant half of each row
+		const int spectrumWidth = size / 2 + 1;
+		const size_t tileLength = static_cast<size_t>(size) * size;
+		const size_t spectrumLength = static_cast<size_t>(size) * spectrumWidth;
+
+		// Plans are taken from cache before parallel part and executed on per thread buffers,
+		// tiles are already processed in parallel, so each transform runs in single thread
+		double* tile = fftw_alloc_real(tileLength);
+		fftw_complex* tileSpectrum = fftw_alloc_complex(spectrumLength);
+		fftw_complex* kernelSpectrum = fftw_alloc_complex(spectrumLength);
+
+		fftw_plan forwardPlan = FFTPlans::GetDouble(size, size, FFTPlans::Direction::Forward, FFTPlans::Domain::Real, tile, tileSpectrum, 1);
+		fftw_plan backwardPlan = FFTPlans::GetDouble(size, size, FFTPlans::Direction::Backward, FFTPlans::Domain::Real, tileSpectrum, tile, 1);
+
+		// Kernel is mirrored around origin (wrapped), so that circular convolution computes correlation
+		// like the direct convolutions, and scaled to compensate unnormalized inverse transform
+		std::fill_n(tile, tileLength, 0.0);
+		for (int kY = 0; kY < kernelSize; kY++) {
+			for (int kX = 0; kX < kernelSize; kX++) {
+				int u = ((center - kX) % size + size) % size;
+				int v = ((center - kY) % size + size) % size;
+				tile[static_cast<size_t>(v) * size + u] = kernel[kX + kY * kernelSize] / (double)tileLength;
+			}
+		}
+		fftw_execute_dft_r2c(forwardPlan, tile, kernelSpectrum);
+
+		const int tilesX = (width + valid - 1) / valid;
+		const int tilesY = (height + valid - 1) / valid;
+
+		Utils::ParallelBands(tilesX * tilesY, [&](int begin, int end) {
+			double* input = fftw_alloc_real(tileLength);
+			fftw_complex* spectrum = fftw_alloc_complex(spectrumLength);
+
+			for (int t = begin; t < end; t++) {
+				const int x0 = (t % tilesX) * valid;
+				const int y0 = (t / tilesX) * valid;
+
+				// Tile with apron, coordinates outside image are clamped
+				for (int v = 0; v < size; v++) {
+					const float* row = source + static_cast<size_t>(std::clamp(y0 - center + v, 0, height - 1)) * width;
+					double* tileRow = input + static_cast<size_t>(v) * size;
+
+					for (int u = 0; u < size; u++) {
+						tileRow[u] = row[std::clamp(x0 - center + u, 0, width - 1)];
+					}
+				}
+
+				fftw_execute_dft_r2c(forwardPlan, input, spectrum);
+
+				for (size_t i = 0; i < spectrumLength; i++) {
+					double re = spectrum[i][0] * kernelSpectrum[i][0] - spectrum[i][1] * kernelSpectrum[i][1];
+					double im = spectrum[i][0] * kernelSpectrum[i][1] + spectrum[i][1] * kernelSpectrum[i][0];
+					spectrum[i][0] = re;
+					spectrum[i][1] = im;
+				}
+
+				fftw_execute_dft_c2r(backwardPlan, spectrum, input);
+
+				// Output pixel (x0 + u, y0 + v) is at (u + center, v + center) of circular result
+				const int validWidth = std::min(valid, width - x0);
+				const int validHeight = std::min(valid, height - y0);
+				for (int v = 0; v < validHeight; v++) {
+					const double* result = input + static_cast<size_t>(v + center) * size + center;
+					float* out = destination + static_cast<size_t>(y0 + v) * width + x0;
+
+					for (int u = 0; u < validWidth; u++) {
+						out[u] = static_cast<float>(result[u]);
+					}
+				}
+			}
+
+			fftw_free(spectrum);
+			fftw_free(input);
+		});
+
+		fftw_free(kernelSpectrum);
+		fftw_free(tileSpectrum);
+		fftw_free(tile);
+	}
+}
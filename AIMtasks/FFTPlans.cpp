@@ -0,0 +1,321 @@
+#include <map>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include "FFTPlans.hpp"
+
+namespace FFTPlans
+{
+	/// <summary> Cached plan of either precision with rigor it was created with </summary>
+	struct Entry {
+		fftw_plan doublePlan = nullptr;
+		fftwf_plan floatPlan = nullptr;
+		Rigor rigor = Rigor::Estimate;
+	};
+
+	/// <summary> Guards cache and planner (FFTW planner is not thread safe, execution is) </summary>
+	static std::mutex cacheMutex;
+	static std::map<Key, Entry> cache;
+	/// <summary> Plans replaced by ones with higher rigor, they may still be executed by other threads </summary>
+	static std::vector<Entry> retired;
+	static Rigor currentRigor = Rigor::Estimate;
+	static int defaultThreads = std::max(1u, std::thread::hardware_concurrency());
+	static std::string wisdomFile;
+
+	/// <summary>
+	/// Uniform access to FFTW functions of given precision.
+	/// </summary>
+	template<typename Real>
+	struct Api;
+
+	template<>
+	struct Api<double> {
+		using Real = double;
+		using Complex = fftw_complex;
+		using Plan = fftw_plan;
+		static constexpr Precision precision = Precision::Double;
+
+		static Plan& Of(Entry& entry) { return entry.doublePlan; }
+		static Real* AllocReal(size_t n) { return fftw_alloc_real(n); }
+		static Complex* AllocComplex(size_t n) { return fftw_alloc_complex(n); }
+		static void Free(void* p) { fftw_free(p); }
+		static bool Aligned(const void* p) { return fftw_alignment_of((double*)p) == 0; }
+#ifdef AIM_FFTW_THREADS
+		static bool threadsInitialized;
+		static void InitThreads() { fftw_init_threads(); }
+		static void PlanWithThreads(int threads) { fftw_plan_with_nthreads(threads); }
+#endif
+		static Plan Dft(const int* n, int count, Complex* in, int inDistance, Complex* out, int outDistance, int sign, unsigned flags)
+		{
+			return fftw_plan_many_dft(2, n, count, in, nullptr, 1, inDistance, out, nullptr, 1, outDistance, sign, flags);
+		}
+		static Plan R2C(const int* n, int count, Real* in, const int* inEmbed, int inDistance, Complex* out, int outDistance, unsigned flags)
+		{
+			return fftw_plan_many_dft_r2c(2, n, count, in, inEmbed, 1, inDistance, out, nullptr, 1, outDistance, flags);
+		}
+		static Plan C2R(const int* n, int count, Complex* in, int inDistance, Real* out, const int* outEmbed, int outDistance, unsigned flags)
+		{
+			return fftw_plan_many_dft_c2r(2, n, count, in, nullptr, 1, inDistance, out, outEmbed, 1, outDistance, flags);
+		}
+	};
+
+	template<>
+	struct Api<float> {
+		using Real = float;
+		using Complex = fftwf_complex;
+		using Plan = fftwf_plan;
+		static constexpr Precision precision = Precision::Float;
+
+		static Plan& Of(Entry& entry) { return entry.floatPlan; }
+		static Real* AllocReal(size_t n) { return fftwf_alloc_real(n); }
+		static Complex* AllocComplex(size_t n) { return fftwf_alloc_complex(n); }
+		static void Free(void* p) { fftwf_free(p); }
+		static bool Aligned(const void* p) { return fftwf_alignment_of((float*)p) == 0; }
+#ifdef AIM_FFTW_THREADS
+		static bool threadsInitialized;
+		static void InitThreads() { fftwf_init_threads(); }
+		static void PlanWithThreads(int threads) { fftwf_plan_with_nthreads(threads); }
+#endif
+		static Plan Dft(const int* n, int count, Complex* in, int inDistance, Complex* out, int outDistance, int sign, unsigned flags)
+		{
+			return fftwf_plan_many_dft(2, n, count, in, nullptr, 1, inDistance, out, nullptr, 1, outDistance, sign, flags);
+		}
+		static Plan R2C(const int* n, int count, Real* in, const int* inEmbed, int inDistance, Complex* out, int outDistance, unsigned flags)
+		{
+			return fftwf_plan_many_dft_r2c(2, n, count, in, inEmbed, 1, inDistance, out, nullptr, 1, outDistance, flags);
+		}
+		static Plan C2R(const int* n, int count, Complex* in, int inDistance, Real* out, const int* outEmbed, int outDistance, unsigned flags)
+		{
+			return fftwf_plan_many_dft_c2r(2, n, count, in, nullptr, 1, inDistance, out, outEmbed, 1, outDistance, flags);
+		}
+	};
+
+#ifdef AIM_FFTW_THREADS
+	bool Api<double>::threadsInitialized = false;
+	bool Api<float>::threadsInitialized = false;
+#endif
+
+	static unsigned RigorFlag(Rigor rigor)
+	{
+		switch (rigor) {
+		case Rigor::Measure:
+			return FFTW_MEASURE;
+		case Rigor::Patient:
+			return FFTW_PATIENT;
+		default:
+			return FFTW_ESTIMATE;
+		}
+	}
+
+	/// <summary>
+	/// Creates plan for given key on scratch buffers (measuring planners overwrite them).
+	/// </summary>
+	template<typename Real>
+	static typename Api<Real>::Plan CreatePlan(const Key& key, Rigor rigor)
+	{
+		using A = Api<Real>;
+
+		const int halfWidth = key.width / 2 + 1;
+		const int realDistance = key.inPlace ? 2 * halfWidth * key.height : key.width * key.height;
+		const int complexDistance = key.domain == Domain::Complex ? key.width * key.height : halfWidth * key.height;
+		const size_t complexLength = static_cast<size_t>(complexDistance) * key.count;
+		const size_t realLength = static_cast<size_t>(realDistance) * key.count;
+		const unsigned flags = RigorFlag(rigor) | (key.aligned ? 0 : FFTW_UNALIGNED);
+		const int n[2] = { key.height, key.width };
+		// Rows of in-place real data are padded to 2 * (width / 2 + 1) values
+		const int paddedEmbed[2] = { key.height, 2 * halfWidth };
+		const int* realEmbed = key.inPlace ? paddedEmbed : nullptr;
+
+#ifdef AIM_FFTW_THREADS
+		if (!A::threadsInitialized) {
+			A::InitThreads();
+			A::threadsInitialized = true;
+		}
+		A::PlanWithThreads(key.threads);
+#endif
+
+		typename A::Complex* spectrum = A::AllocComplex(complexLength);
+		typename A::Plan plan = nullptr;
+
+		if (key.domain == Domain::Complex) {
+			typename A::Complex* other = key.inPlace ? spectrum : A::AllocComplex(complexLength);
+			int sign = key.direction == Direction::Forward ? FFTW_FORWARD : FFTW_BACKWARD;
+
+			plan = A::Dft(n, key.count, other, complexDistance, spectrum, complexDistance, sign, flags);
+
+			if (!key.inPlace) {
+				A::Free(other);
+			}
+		} else {
+			Real* real = key.inPlace ? reinterpret_cast<Real*>(spectrum) : A::AllocReal(realLength);
+
+			if (key.direction == Direction::Forward) {
+				plan = A::R2C(n, key.count, real, realEmbed, realDistance, spectrum, complexDistance, flags);
+			} else {
+				plan = A::C2R(n, key.count, spectrum, complexDistance, real, realEmbed, realDistance, flags);
+			}
+
+			if (!key.inPlace) {
+				A::Free(real);
+			}
+		}
+
+		A::Free(spectrum);
+
+		return plan;
+	}
+
+	template<typename Real>
+	static typename Api<Real>::Plan Get(int width, int height, int count, Direction direction, Domain domain, const void* input, const void* output, int threads)
+	{
+		using A = Api<Real>;
+
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+#ifdef AIM_FFTW_THREADS
+		threads = threads > 0 ? threads : defaultThreads;
+#else
+		threads = 1;
+#endif
+
+		Key key = {
+			width,
+			height,
+			count,
+			direction,
+			A::precision,
+			domain,
+			input == output,
+			A::Aligned(input) && A::Aligned(output),
+			threads
+		};
+
+		Entry& entry = cache[key];
+		typename A::Plan& plan = A::Of(entry);
+
+		if (plan == nullptr || entry.rigor < currentRigor) {
+			if (plan != nullptr) {
+				retired.push_back(entry);
+			}
+
+			plan = CreatePlan<Real>(key, currentRigor);
+			entry.rigor = currentRigor;
+		}
+
+		return plan;
+	}
+
+	fftw_plan GetDouble(int width, int height, Direction direction, Domain domain, const void* input, const void* output, int threads)
+	{
+		return Get<double>(width, height, 1, direction, domain, input, output, threads);
+	}
+
+	fftwf_plan GetFloat(int width, int height, Direction direction, Domain domain, const void* input, const void* output, int threads)
+	{
+		return Get<float>(width, height, 1, direction, domain, input, output, threads);
+	}
+
+	fftw_plan GetDoubleMany(int width, int height, int count, Direction direction, Domain domain, const void* input, const void* output, int threads)
+	{
+		return Get<double>(width, height, count, direction, domain, input, output, threads);
+	}
+
+	fftwf_plan GetFloatMany(int width, int height, int count, Direction direction, Domain domain, const void* input, const void* output, int threads)
+	{
+		return Get<float>(width, height, count, direction, domain, input, output, threads);
+	}
+
+	void SetThreads(int threads)
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		defaultThreads = std::max(1, threads);
+	}
+
+	int GetThreads()
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		return defaultThreads;
+	}
+
+	bool ThreadsAvailable()
+	{
+#ifdef AIM_FFTW_THREADS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void SetRigor(Rigor rigor)
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		currentRigor = rigor;
+	}
+
+	Rigor GetRigor()
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		return currentRigor;
+	}
+
+	bool LoadWisdom(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+		bool doubleLoaded = fftw_import_wisdom_from_filename(path.c_str()) != 0;
+		bool floatLoaded = fftwf_import_wisdom_from_filename((path + ".float").c_str()) != 0;
+
+		return doubleLoaded || floatLoaded;
+	}
+
+	bool SaveWisdom(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+		bool doubleSaved = fftw_export_wisdom_to_filename(path.c_str()) != 0;
+		bool floatSaved = fftwf_export_wisdom_to_filename((path + ".float").c_str()) != 0;
+
+		return doubleSaved && floatSaved;
+	}
+
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+		for (auto& [key, entry] : cache) {
+			retired.push_back(entry);
+		}
+		cache.clear();
+
+		for (Entry& entry : retired) {
+			if (entry.doublePlan != nullptr) {
+				fftw_destroy_plan(entry.doublePlan);
+			}
+			if (entry.floatPlan != nullptr) {
+				fftwf_destroy_plan(entry.floatPlan);
+			}
+		}
+		retired.clear();
+	}
+
+	void Initialize(const std::string& wisdomPath, Rigor rigor)
+	{
+		SetRigor(rigor);
+
+		wisdomFile = wisdomPath;
+		if (!wisdomFile.empty()) {
+			LoadWisdom(wisdomFile);
+		}
+	}
+
+	void Shutdown()
+	{
+		if (!wisdomFile.empty()) {
+			SaveWisdom(wisdomFile);
+		}
+
+		Clear();
+	}
+}
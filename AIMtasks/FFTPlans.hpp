@@ -0,0 +1,150 @@
+#pragma once
+
+#include <string>
+
+#include <fftw3.h>
+
+/// <summary>
+/// Process wide cache of 2D FFTW plans.
+///
+/// Plans are created on first request for given transform and reused by all later calls, they are
+/// executed by new-array functions (fftw_execute_dft, fftw_execute_dft_r2c, ...) on caller's buffers.
+/// Planning runs on internal scratch buffers, so even measured planning never touches caller's data.
+/// Accumulated FFTW wisdom can be loaded at startup and saved at shutdown, so that measured plans
+/// are not searched again by every process.
+/// </summary>
+namespace FFTPlans
+{
+	/// <summary> Floating point type of transformed data </summary>
+	enum class Precision {
+		Double,
+		Float
+	};
+
+	/// <summary> Direction of transform </summary>
+	enum class Direction {
+		Forward,
+		Backward
+	};
+
+	/// <summary> Type of transformed data </summary>
+	enum class Domain {
+		/// <summary> Complex to complex transform of whole spectrum </summary>
+		Complex,
+		/// <summary> Real to complex (forward) or complex to real (backward), spectrum has width / 2 + 1 columns </summary>
+		Real
+	};
+
+	/// <summary> How much time planner spends searching for the fastest plan </summary>
+	enum class Rigor {
+		/// <summary> Heuristic plan without any measurement (FFTW_ESTIMATE) </summary>
+		Estimate,
+		/// <summary> Measures several candidate algorithms (FFTW_MEASURE) </summary>
+		Measure,
+		/// <summary> Measures much wider range of algorithms, planning may take minutes (FFTW_PATIENT) </summary>
+		Patient
+	};
+
+	/// <summary>
+	/// Identification of cached plan.
+	/// </summary>
+	struct Key {
+		int width;
+		int height;
+		/// <summary> Number of transforms stored one after another (batch) </summary>
+		int count;
+		Direction direction;
+		Precision precision;
+		Domain domain;
+		/// <summary> Input and output is the same buffer (rows of real data padded to 2 * (width / 2 + 1)) </summary>
+		bool inPlace;
+		/// <summary> Both buffers are SIMD aligned like fftw_malloc ones, otherwise plan is created as unaligned </summary>
+		bool aligned;
+		/// <summary> Number of threads executing the plan </summary>
+		int threads;
+
+		auto operator<=>(const Key&) const = default;
+	};
+
+	/// <summary>
+	/// Returns cached double precision plan for transform of height rows of width values between given buffers
+	/// (creates it when missing or when it was created with lower rigor than current one).
+	/// </summary>
+	/// <param name="width">Number of columns (faster dimension)</param>
+	/// <param name="height">Number of rows</param>
+	/// <param name="direction">Direction of transform</param>
+	/// <param name="domain">Complex or real transform</param>
+	/// <param name="input">Buffer the plan will be executed on (used only to determine alignment and in-place)</param>
+	/// <param name="output">Buffer the plan will write to</param>
+	/// <param name="threads">Number of threads executing the plan, 0 uses global setting</param>
+	fftw_plan GetDouble(int width, int height, Direction direction, Domain domain, const void* input, const void* output, int threads = 0);
+
+	/// <summary>
+	/// Returns cached single precision plan, see GetDouble.
+	/// </summary>
+	fftwf_plan GetFloat(int width, int height, Direction direction, Domain domain, const void* input, const void* output, int threads = 0);
+
+	/// <summary>
+	/// Returns cached double precision plan transforming count images stored contiguously one after another
+	/// (each has width * height values, width / 2 + 1 columns of real transform spectrum, or padded rows
+	/// of 2 * (width / 2 + 1) real values when in place), see GetDouble.
+	/// </summary>
+	fftw_plan GetDoubleMany(int width, int height, int count, Direction direction, Domain domain, const void* input, const void* output, int threads = 0);
+
+	/// <summary>
+	/// Returns cached single precision plan of batch of transforms, see GetDoubleMany.
+	/// </summary>
+	fftwf_plan GetFloatMany(int width, int height, int count, Direction direction, Domain domain, const void* input, const void* output, int threads = 0);
+
+	/// <summary>
+	/// Sets number of threads used by plans requested without explicit thread count (default is number of cores).
+	/// </summary>
+	void SetThreads(int threads);
+
+	/// <summary>
+	/// Returns global number of threads of plans.
+	/// </summary>
+	int GetThreads();
+
+	/// <summary>
+	/// Whether library was linked with threaded FFTW (AIM_FFTW_THREADS), otherwise all plans are single threaded.
+	/// </summary>
+	bool ThreadsAvailable();
+
+	/// <summary>
+	/// Sets rigor of planning of plans created from now on.
+	/// </summary>
+	void SetRigor(Rigor rigor);
+
+	/// <summary>
+	/// Returns current rigor of planning.
+	/// </summary>
+	Rigor GetRigor();
+
+	/// <summary>
+	/// Imports wisdom of both precisions, double from given path and single from path with ".float" appended.
+	/// </summary>
+	/// <returns>True if at least one file was imported.</returns>
+	bool LoadWisdom(const std::string& path);
+
+	/// <summary>
+	/// Exports accumulated wisdom of both precisions (to the same files LoadWisdom reads).
+	/// </summary>
+	/// <returns>True if both files were written.</returns>
+	bool SaveWisdom(const std::string& path);
+
+	/// <summary>
+	/// Destroys all cached plans.
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Sets planning rigor and loads wisdom from given file (when path is not empty), call at application startup.
+	/// </summary>
+	void Initialize(const std::string& wisdomPath = "", Rigor rigor = Rigor::Estimate);
+
+	/// <summary>
+	/// Saves wisdom to file given to Initialize (if any) and destroys cached plans, call at application shutdown.
+	/// </summary>
+	void Shutdown();
+}
@@ -0,0 +1,89 @@
+#include "Guided.hpp"
+#include "Convolution.hpp"
+#include "Utils.hpp"
+
+namespace Guided
+{
+	void Filter(
+		const std::vector<float>& source,
+		const std::vector<float>& guide,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		int radius,
+		float epsilon
+	) {
+		destination.resize(source.size());
+		Filter(source.data(), guide.data(), destination.data(), width, height, radius, epsilon);
+	}
+
+	void Filter(
+		const float* source,
+		const float* guide,
+		float* destination,
+		int width,
+		int height,
+		int radius,
+		float epsilon
+	) {
+		const size_t size = static_cast<size_t>(width) * height;
+		const bool selfGuided = source == guide;
+
+		// Products whose window means give variance of guide and covariance of guide and source
+		std::vector<float> meanGuide(size);
+		std::vector<float> meanSource(selfGuided ? 0 : size);
+		std::vector<float> guideSquared(size);
+		std::vector<float> guideSource(selfGuided ? 0 : size);
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			const size_t last = static_cast<size_t>(end) * width;
+
+			for (size_t i = static_cast<size_t>(begin) * width; i < last; i++) {
+				guideSquared[i] = guide[i] * guide[i];
+				if (!selfGuided) {
+					guideSource[i] = guide[i] * source[i];
+				}
+			}
+		});
+
+		Convolution::Box(guide, meanGuide.data(), width, height, radius);
+		Convolution::Box(guideSquared.data(), guideSquared.data(), width, height, radius);
+		if (!selfGuided) {
+			Convolution::Box(source, meanSource.data(), width, height, radius);
+			Convolution::Box(guideSource.data(), guideSource.data(), width, height, radius);
+		}
+
+		const std::vector<float>& sourceMean = selfGuided ? meanGuide : meanSource;
+		const std::vector<float>& productMean = selfGuided ? guideSquared : guideSource;
+
+		// Coefficients of linear model of every window, a is stored over guideSquared and b over meanGuide
+		std::vector<float>& a = guideSquared;
+		std::vector<float>& b = meanGuide;
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			const size_t last = static_cast<size_t>(end) * width;
+
+			for (size_t i = static_cast<size_t>(begin) * width; i < last; i++) {
+				float mean = meanGuide[i];
+				float variance = guideSquared[i] - mean * mean;
+				float covariance = productMean[i] - mean * sourceMean[i];
+
+				float coefficient = covariance / (variance + epsilon);
+				b[i] = sourceMean[i] - coefficient * mean;
+				a[i] = coefficient;
+			}
+		});
+
+		Convolution::Box(a.data(), a.data(), width, height, radius);
+		Convolution::Box(b.data(), b.data(), width, height, radius);
+
+		// Every pixel averages models of all windows covering it
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			const size_t last = static_cast<size_t>(end) * width;
+
+			for (size_t i = static_cast<size_t>(begin) * width; i < last; i++) {
+				destination[i] = a[i] * guide[i] + b[i];
+			}
+		});
+	}
+}
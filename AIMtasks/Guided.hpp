@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+/// <summary>
+/// Namespace with guided filter (He, Sun, Tang: Guided image filtering, 2010).
+/// </summary>
+namespace Guided
+{
+	/// <summary>
+	/// Edge preserving smoothing of source by local linear model of guide, q = a * I + b in every window.
+	///
+	/// Built from six box filters (Convolution::Box), so cost per pixel does not depend on radius,
+	/// all passes run in parallel bands. When guide is source itself, two of box filters are skipped.
+	/// </summary>
+	/// <param name="source">Input image data</param>
+	/// <param name="guide">Image data whose edges are preserved (may be source itself)</param>
+	/// <param name="destination">Vector where to save filtered image</param>
+	/// <param name="width">Width of both images</param>
+	/// <param name="height">Height of both images</param>
+	/// <param name="radius">Radius of square window</param>
+	/// <param name="epsilon">Regularization, variance of guide below which window is smoothed (e.g. 0.01 for <0,1> images)</param>
+	void Filter(
+		const std::vector<float>& source,
+		const std::vector<float>& guide,
+		std::vector<float>& destination,
+		int width,
+		int height,
+		int radius,
+		float epsilon
+	);
+
+	/// <summary>
+	/// Filter on raw buffers of width * height values, guide is recognized as source by equal pointers.
+	/// </summary>
+	void Filter(
+		const float* source,
+		const float* guide,
+		float* destination,
+		int width,
+		int height,
+		int radius,
+		float epsilon
+	);
+}
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+#include "Histogram.hpp"
+#include "Utils.hpp"
+
+namespace Histogram
+{
+	/// <summary> Number of values counted by one task </summary>
+	static const size_t BlockSize = 1 << 18;
+
+	/// <summary> Largest number of bins counted into interleaved copies </summary>
+	static const int InterleavedBins = 4096;
+
+	/// <summary>
+	/// Bin of value, value is clamped to <0,1> and rounded to nearest of bins evenly spaced levels.
+	/// </summary>
+	static inline int BinOf(float value, float scale)
+	{
+		// Clamped values are non-negative, so adding 0.5 and truncating rounds to nearest
+		return static_cast<int>(std::clamp(value, 0.0f, 1.0f) * scale + 0.5f);
+	}
+
+	/// <summary>
+	/// Bin of value as functor, float values are rounded to nearest bin, integer codes are bins themselves.
+	/// </summary>
+	struct ValueBin {
+		float scale;
+		int operator()(float value) const { return BinOf(value, scale); }
+	};
+
+	struct CodeBin {
+		int operator()(int code) const { return code; }
+	};
+
+	/// <summary>
+	/// Counts values into Ways interleaved copies of histogram (bin b of copy w is at b * Ways + w).
+	/// </summary>
+	template <int Ways, typename Value, typename Bin>
+	static void CountBlock(const Value* data, size_t count, Bin bin, uint32_t* counters)
+	{
+		size_t i = 0;
+		for (; i + Ways <= count; i += Ways) {
+			for (int way = 0; way < Ways; way++) {
+				counters[bin(data[i + way]) * Ways + way]++;
+			}
+		}
+		for (; i < count; i++) {
+			counters[bin(data[i]) * Ways]++;
+		}
+	}
+
+	/// <summary>
+	/// Counts values into private counters of parallel workers and sums them.
+	/// </summary>
+	template <typename Value, typename Bin>
+	static std::vector<int> Count(const Value* data, size_t count, int bins, Bin bin)
+	{
+		const int ways = bins <= InterleavedBins ? 4 : 1;
+		const int blocks = static_cast<int>((count + BlockSize - 1) / BlockSize);
+
+		// One band of consecutive blocks per worker thread, so that number of private counters (and cost
+		// of summing them) is given by number of cores and not by number of bands
+		const int workers = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, std::max(blocks, 1));
+		std::vector<std::vector<uint32_t>> partials(workers);
+
+		Utils::ParallelBands(workers, [&](int begin, int end) {
+			for (int worker = begin; worker < end; worker++) {
+				std::vector<uint32_t>& counters = partials[worker];
+				counters.assign(static_cast<size_t>(bins) * ways, 0);
+
+				const int lastBlock = static_cast<int>(static_cast<int64_t>(blocks) * (worker + 1) / workers);
+				for (int block = static_cast<int>(static_cast<int64_t>(blocks) * worker / workers); block < lastBlock; block++) {
+					const Value* values = data + block * BlockSize;
+					const size_t length = std::min(BlockSize, count - block * BlockSize);
+
+					if (ways == 4) {
+						CountBlock<4>(values, length, bin, counters.data());
+					} else {
+						CountBlock<1>(values, length, bin, counters.data());
+					}
+				}
+			}
+		});
+
+		std::vector<int> histogram(bins, 0);
+
+		Utils::ParallelBands(bins, [&](int begin, int end) {
+			for (const std::vector<uint32_t>& counters : partials) {
+				for (int b = begin; b < end; b++) {
+					for (int way = 0; way < ways; way++) {
+						histogram[b] += counters[static_cast<size_t>(b) * ways + way];
+					}
+				}
+			}
+		});
+
+		return histogram;
+	}
+
+	/// <summary>
+	/// Counts every code and folds counts of codes into bins of their values.
+	/// </summary>
+	template <typename Code>
+	static std::vector<int> CountCodes(const Code* data, size_t count, int bins)
+	{
+		constexpr int codes = 1 << (8 * sizeof(Code));
+		const float maximum = static_cast<float>(codes - 1);
+		const ValueBin bin = { static_cast<float>(bins - 1) };
+
+		std::vector<int> codeHistogram = Count(data, count, codes, CodeBin());
+		if (bins == codes) {
+			return codeHistogram;
+		}
+
+		std::vector<int> histogram(bins, 0);
+		for (int code = 0; code < codes; code++) {
+			histogram[bin(code / maximum)] += codeHistogram[code];
+		}
+
+		return histogram;
+	}
+
+	std::vector<int> Compute(const float* data, size_t count, int bins)
+	{
+		bins = std::max(bins, 1);
+
+		return Count(data, count, bins, ValueBin{ static_cast<float>(bins - 1) });
+	}
+
+	std::vector<int> Compute(const uint8_t* data, size_t count, int bins)
+	{
+		return CountCodes(data, count, std::max(bins, 1));
+	}
+
+	std::vector<int> Compute(const uint16_t* data, size_t count, int bins)
+	{
+		return CountCodes(data, count, std::max(bins, 1));
+	}
+
+	std::vector<int> Remap(const std::vector<int>& histogram, const std::function<float(float)>& mapping)
+	{
+		const int bins = static_cast<int>(histogram.size());
+		const float scale = static_cast<float>(bins - 1);
+
+		std::vector<int> remapped(bins, 0);
+		for (int b = 0; b < bins; b++) {
+			if (histogram[b] != 0) {
+				remapped[BinOf(mapping(b / scale), scale)] += histogram[b];
+			}
+		}
+
+		return remapped;
+	}
+
+	std::vector<float> Cumulative(const std::vector<int>& histogram)
+	{
+		std::vector<float> cumulative(histogram.size());
+
+		double total = 0.0;
+		for (int value : histogram) {
+			total += value;
+		}
+
+		double sum = 0.0;
+		for (size_t i = 0; i < histogram.size(); i++) {
+			sum += histogram[i];
+			cumulative[i] = total > 0.0 ? static_cast<float>(sum / total) : 0.0f;
+		}
+
+		return cumulative;
+	}
+}
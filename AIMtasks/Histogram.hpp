@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/// <summary>
+/// Namespace with histogram of grayscale float data in <0,1>.
+/// </summary>
+namespace Histogram
+{
+	/// <summary>
+	/// Counts values into given number of bins, value v falls into bin round(v * (bins - 1)) (clamped to <0,1>).
+	///
+	/// Blocks of data run in parallel and each of them counts into its private histogram, which are summed
+	/// at the end. Up to 4096 bins block counts into four interleaved copies, so that runs of equal values
+	/// (flat areas) do not wait for increments of the same counter.
+	/// </summary>
+	/// <param name="data">Values to count</param>
+	/// <param name="count">Number of values</param>
+	/// <param name="bins">Number of bins, e.g. 256 for 8-bit, 4096 for 12-bit and 65536 for 16-bit sources</param>
+	/// <returns>Counts of all bins</returns>
+	std::vector<int> Compute(const float* data, size_t count, int bins);
+
+	/// <summary>
+	/// Counts integer codes (code c stands for value c / 255 or c / 65535) into the same bins as Compute
+	/// of their values. Codes are counted directly without conversion to float and folded into bins.
+	/// </summary>
+	std::vector<int> Compute(const uint8_t* data, size_t count, int bins);
+	std::vector<int> Compute(const uint16_t* data, size_t count, int bins);
+
+	/// <summary>
+	/// Histogram of data mapped by point operation, computed in O(bins) instead of counting pixels again:
+	/// count of every bin is moved to bin of its centre value (b / (bins - 1)) mapped by given function.
+	///
+	/// It is exact when values lie on bin centres, otherwise all values of bin follow its centre, so that
+	/// values near bin border may end one bin away from where recount (Compute) puts them.
+	/// </summary>
+	/// <param name="histogram">Histogram of data before mapping</param>
+	/// <param name="mapping">Point operation applied to data</param>
+	/// <returns>Histogram of mapped data with the same number of bins</returns>
+	std::vector<int> Remap(const std::vector<int>& histogram, const std::function<float(float)>& mapping);
+
+	/// <summary>
+	/// Normalized cumulative distribution of histogram, the last value is 1.
+	/// </summary>
+	std::vector<float> Cumulative(const std::vector<int>& histogram);
+}
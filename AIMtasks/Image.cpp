@@ -12,16 +12,24 @@
 #include <string>
 #include <execution>
 #include <algorithm>
+#include <numeric>
 
 #include "Image.hpp"
-
-Image::Image(std::string path) {
+#include "Bilateral.hpp"
+#include "Convolution.hpp"
+#include "FFTPlans.hpp"
+#include "Clahe.hpp"
+#include "Color.hpp"
+#include "Guided.hpp"
+#include "Histogram.hpp"
+#include "Monadic.hpp"
+#include "Spectrum.hpp"
+#include "SummedAreaTable.hpp"
+
+Image::Image(std::string path, bool keepChannels) {
     this->path = path;
 
-    load(path);
-
-    computeHistogram();
-    computeCDF();
+    load(path, keepChannels);
 }
 
 Image::Image(std::vector<float>& imageData, std::string path, int width, int height, int components) {
@@ -29,6 +37,7 @@ Image::Image(std::vector<float>& imageData, std::string path, int width, int hei
     this->width = width;
     this->height = height;
     this->components = components;
+    this->channels = std::max(1, (int)(imageData.size() / std::max<size_t>(planeSize(), 1)));
 
 
     this->data.resize(imageData.size());
@@ -38,24 +47,46 @@ Image::Image(std::vector<float>& imageData, std::string path, int width, int hei
 }
 
 Image::~Image() {
-    if (complexSpectrum != nullptr) {
-        fftw_free(complexSpectrum);
-    }
+    freeSpectrum();
 }
 
-bool Image::load(std::string path) {
+bool Image::load(std::string path, bool keepChannels) {
     int ok = stbi_info(path.c_str(), &width, &height, &components);
 
     if (ok == 1) {
         unsigned char* indata = stbi_load(path.c_str(), &width, &height, &components, 0);
+        if (indata == nullptr) {
+            return false;
+        }
+
+        channels = keepChannels ? components : 1;
 
         data.clear();
-        data.resize(width * height);
+        data.resize(planeSize() * channels);
 
         std::cout << "Comp: " << components << std::endl;
-        if (components == 3) {
-            RGBToLuminanceImage(indata, width, height);
+        if (components >= 3) {
+            if (keepChannels) {
+                Color::Layout layout = components == 4 ? Color::Layout::RGBA : Color::Layout::RGB;
+                Color::Decode(indata, layout, width, height, Color::Space::RGB, data.data(), components == 4 ? plane(3) : nullptr);
+            } else {
+                RGBToLuminanceImage(indata, width, height);
+            }
+        } else {
+            // Components are copied to planes through interleaved view, gray with alpha keeps alpha only with keepChannels
+            InterleavedView view{ data.data(), width, height, channels };
+            Utils::ParallelBands(height, [&](int begin, int end) {
+                for (int y = begin; y < end; y++) {
+                    const unsigned char* row = indata + (size_t)y * width * components;
+                    for (int x = 0; x < width; x++) {
+                        for (int c = 0; c < channels; c++) {
+                            view(x, y, c) = row[(size_t)x * components + c] / 255.0f;
+                        }
+                    }
+                }
+            });
         }
+        markModified();
 
         stbi_image_free(indata);
         return true;
@@ -68,389 +99,584 @@ void Image::save(std::string prefix, OperationDataSource dataSource) {
     std::string out = prefix.append(path);
     std::cout << out << std::endl;
 
-    std::vector<float>& imageData = dataSource == Image::OperationDataSource::IMAGE ? data : spectrum;
-    std::vector<char> outputData(width * height * 3);
-
-    for (int i = 0; i < imageData.size(); i++) {
-        int val = imageData[i] * 255;
+    if (dataSource == Image::OperationDataSource::IMAGE) {
+        evaluate();
+    } else {
+        updateSpectrum();
+    }
 
-        outputData[i * 3 + 0] = val;
-        outputData[i * 3 + 1] = val;
-        outputData[i * 3 + 2] = val;
+    // Spectrum has the same planes as data
+    std::vector<float>& imageData = dataSource == Image::OperationDataSource::IMAGE ? data : spectrum;
+    InterleavedView view{ imageData.data(), width, height, channels };
+    std::vector<unsigned char> outputData(view.size());
+
+    if (channels == 3 || channels == 4) {
+        Color::Layout layout = channels == 4 ? Color::Layout::RGBA : Color::Layout::RGB;
+        Color::Encode(imageData.data(), Color::Space::RGB, width, height, layout, outputData.data(), channels == 4 ? &view(0, 0, 3) : nullptr);
+    } else {
+        Utils::ParallelBands(height, [&](int begin, int end) {
+            for (int y = begin; y < end; y++) {
+                unsigned char* row = outputData.data() + (size_t)y * width * channels;
+                for (int x = 0; x < width; x++) {
+                    for (int c = 0; c < channels; c++) {
+                        row[(size_t)x * channels + c] = (unsigned char)std::clamp(view(x, y, c) * 255.0f, 0.0f, 255.0f);
+                    }
+                }
+            }
+        });
     }
 
-    stbi_write_jpg(out.c_str(), width, height, components, static_cast<void*>(outputData.data()), quality);
+    stbi_write_jpg(out.c_str(), width, height, channels, static_cast<void*>(outputData.data()), quality);
 
 }
 
-void Image::doOperation(MonadicOperationType operation, float value) {
+void Image::doOperation(MonadicOperationType operation, float value, bool saveResult) {
+    std::string prefix;
+
     switch (operation) {
     case MonadicOperationType::NEGATIVE:
-        negative();
-        save("n_");
+        prefix = "n_";
         break;
     case MonadicOperationType::THRESHOLD:
-        threshold(value);
-        save("t_");
+        prefix = "t_";
         break;
     case MonadicOperationType::BRIGHTNESS:
-        brightness(value);
-        save("b_");
+        prefix = "b_";
         break;
     case MonadicOperationType::CONTRAST:
-        contrast(value);
-        save("c_");
+        prefix = "c_";
         break;
     case MonadicOperationType::GAMMA_CORRECTION:
-        gammaCorrection(value);
-        save("g_");
+        prefix = "g_";
         break;
     case MonadicOperationType::QUANTIZATION:
-        quantization(static_cast<int>(value));
-        save("q_");
+        prefix = "q_";
         break;
     case MonadicOperationType::HISTOGRAM_EQUALIZATION:
-        histogramEqualization();
-        save("h_");
+        prefix = "h_";
         break;
-    default:
+    case MonadicOperationType::ADAPTIVE_HISTOGRAM_EQUALIZATION:
+        prefix = "a_";
         break;
+    default:
+        return;
+    }
+
+    queueOperation(operation, value);
+
+    if (saveResult) {
+        save(prefix);
     }
 }
 
-void Image::RGBToLuminanceImage(unsigned char* image, int nu, int nv)
-{
-    for (int u = 0; u < nu; u++) {
-        for (int v = 0; v < nv; v++) {
-            int index = v * nu + u;
+bool Image::applyLookupTable(const std::vector<MonadicOperation>& chain, int bits) {
+    evaluate();
+
+    if (bits == 8) {
+        std::vector<uint8_t> table;
+        if (!Monadic::Compile(chain, table)) {
+            return false;
+        }
 
-            float r = image[index * 3];
-            float g = image[index * 3 + 1];
-            float b = image[index * 3 + 2];
+        std::vector<uint8_t> codes(data.size());
+        std::transform(std::execution::par_unseq, data.begin(), data.end(), codes.begin(), [](float value) {
+            return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+        });
 
-            float l = Utils::luminanceFromRGB(r, g, b) / 256.0f;
+        Monadic::Apply(table, codes.data(), codes.data(), codes.size());
 
-            data[index] = l;
+        std::transform(std::execution::par_unseq, codes.begin(), codes.end(), data.begin(), [](uint8_t code) {
+            return code / 255.0f;
+        });
+    } else if (bits == 16) {
+        std::vector<uint16_t> table;
+        if (!Monadic::Compile(chain, table)) {
+            return false;
         }
-    }
-}
 
-void Image::computeHistogram() {
-    histogram.clear();
-    histogram.resize(256);
+        std::vector<uint16_t> codes(data.size());
+        std::transform(std::execution::par_unseq, data.begin(), data.end(), codes.begin(), [](float value) {
+            return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+        });
 
-    for (float value : data) {
-        int level = std::round(value * 255);
+        Monadic::Apply(table, codes.data(), codes.data(), codes.size());
 
-        histogram[level] += 1;
+        std::transform(std::execution::par_unseq, codes.begin(), codes.end(), data.begin(), [](uint16_t code) {
+            return code / 65535.0f;
+        });
+    } else {
+        std::cout << "Lookup tables support only 8 and 16 bit codes" << std::endl;
+        return false;
     }
+
+    markModified();
+
+    return true;
 }
 
-void Image::computeCDF() {
-    float pixelCount = width * height;
+void Image::queueOperation(MonadicOperationType operation, float value) {
+    pendingOperations.push_back({ operation, value });
+}
 
-    if (histogram.empty()) {
-        computeHistogram();
+void Image::evaluate() {
+    if (pendingOperations.empty()) {
+        return;
     }
 
-    CDF.clear();
-    CDF.resize(256);
+    // Operations are cleared first, so that nothing called from here evaluates them again
+    std::vector<MonadicOperation> chain = Monadic::Simplify(pendingOperations);
+    pendingOperations.clear();
+
+    // Adaptive equalization depends on neighbourhood of pixel, so parts of chain between them run fused
+    auto begin = chain.begin();
+    while (begin != chain.end()) {
+        auto end = std::find_if(begin, chain.end(), [](const MonadicOperation& operation) {
+            return operation.type == MonadicOperationType::ADAPTIVE_HISTOGRAM_EQUALIZATION;
+        });
+
+        applyFused(std::vector<MonadicOperation>(begin, end));
+
+        if (end != chain.end()) {
+            // Tiles are local to plane, so every channel is equalized on its own
+            std::vector<int> planes(channels);
+            std::iota(planes.begin(), planes.end(), 0);
+            std::for_each(std::execution::par, planes.begin(), planes.end(), [&](int channel) {
+                Clahe::Apply(plane(channel), plane(channel), width, height, adaptiveTilesX, adaptiveTilesY, end->value, histogramBins);
+            });
+            markModified();
+            end++;
+        }
 
-    CDF[0] = histogram[0] / pixelCount;
-    for (int i = 1; i < 256; i++) {
-        CDF[i] = CDF[i - 1] + histogram[i] / pixelCount;
+        begin = end;
     }
 }
 
-void Image::computeSpectrum() {
-    int imageSize = width * height;
-    std::vector<float> tempSpectrum(imageSize);
+void Image::applyFused(const std::vector<MonadicOperation>& chain) {
+    if (chain.empty()) {
+        return;
+    }
+
+    const bool equalizes = std::any_of(chain.begin(), chain.end(), [](const MonadicOperation& operation) {
+        return operation.type == MonadicOperationType::HISTOGRAM_EQUALIZATION;
+    });
 
-    fftw_complex* sourceImage = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * imageSize);
-    complexSpectrum = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * imageSize);
+    // Histogram counted from data before chain is carried through it by remapping its bins, so CDF of data
+    // at position of every equalization is known before pixels are touched and whole chain still runs in one
+    // pass. Remapping rounds every move to whole bin, so carried histogram is not kept after chain (it would
+    // drift from data over many evaluations) and the next equalization counts pixels again.
+    std::vector<std::vector<float>> cdfs;
 
-    fftw_plan fwPlan = fftw_plan_dft_2d(width, height, sourceImage, complexSpectrum, FFTW_FORWARD, FFTW_ESTIMATE);
+    if (equalizes) {
+        std::vector<int> carried = getHistogram();
+
+        for (const MonadicOperation& operation : chain) {
+            const float* cdf = nullptr;
+            int levels = 0;
+
+            if (operation.type == MonadicOperationType::HISTOGRAM_EQUALIZATION) {
+                cdfs.push_back(Histogram::Cumulative(carried));
+                cdf = cdfs.back().data();
+                levels = static_cast<int>(cdfs.back().size());
+            }
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            sourceImage[y * width + x][0] = (double)data[y * width + x];
-            sourceImage[y * width + x][1] = 0.0;
+            carried = Histogram::Remap(carried, [&](float x) { return Monadic::Evaluate(operation, x, cdf, levels); });
         }
     }
 
-    fftw_execute(fwPlan);
-    fftw_destroy_plan(fwPlan);
-    fftw_free(sourceImage);
+    Monadic::ApplyFused(chain, data.data(), data.size(), cdfs);
 
-    
-    // Modify generated complex spectrum to be able to display it
-    double maximalMagnitude = 0.0;
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            double re = complexSpectrum[y * width + x][0];
-            double im = complexSpectrum[y * width + x][1];
-            double mag = sqrt(re * re + im * im);
-
-            maximalMagnitude = std::max(maximalMagnitude, mag);
-        }
+    markModified();
+}
+
+void Image::applyOperations(const std::vector<MonadicOperation>& chain) {
+    pendingOperations.insert(pendingOperations.end(), chain.begin(), chain.end());
+    evaluate();
+}
+
+void Image::RGBToLuminanceImage(unsigned char* image, int nu, int nv)
+{
+    Color::Layout layout = components == 4 ? Color::Layout::RGBA : Color::Layout::RGB;
+    Color::Decode(image, layout, nu, nv, Color::Space::LUMINANCE, data.data());
+}
+
+size_t Image::planeSize() const {
+    return (size_t)width * height;
+}
+
+float* Image::plane(int channel) {
+    return data.data() + channel * planeSize();
+}
+
+Image::InterleavedView Image::interleaved() {
+    evaluate();
+    return { data.data(), width, height, channels };
+}
+
+void Image::filterPlanes(
+    std::vector<float>& destination,
+    const std::function<void(const float*, float*, int)>& filter
+) {
+    const size_t size = planeSize();
+    destination.resize(size * channels);
+
+    if (channels == 1) {
+        filter(data.data(), destination.data(), 0);
+        return;
     }
 
-    //const double factor = log(1.0 + maximalMagnitude);
+    std::vector<int> planes(channels);
+    std::iota(planes.begin(), planes.end(), 0);
+    std::for_each(std::execution::par, planes.begin(), planes.end(), [&](int channel) {
+        filter(data.data() + channel * size, destination.data() + channel * size, channel);
+    });
+}
 
-    spectrum.resize(imageSize);  
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            double re = complexSpectrum[y * width + x][0];
-            double im = complexSpectrum[y * width + x][1];
-            
-            double mag = sqrt(re * re + im * im);
-            /*
-            tempSpectrum[y * width + x] = mag;
-
-            //spectrum[y * width + x] = mag;
-            //spectrum[Index2Dto1D((x + (width / 2 + 1)) % width, (y + (height / 2) + (x > width / 2 ? 1 : 0)) % height)] = mag;
-            */
-            spectrum[Index2Dto1D((x + (width / 2 + 1)) % width, (y + (height / 2)) % height)] = log10(1.0 + mag);
-        }
+const float* Image::guidePlane(Image& guide, const float* source, int channel) const {
+    if (&guide == this) {
+        return source;
+    }
+    if (guide.channels == 1) {
+        return guide.data.data();
     }
+
+    return guide.data.data() + (guide.channels == channels ? channel : 0) * guide.planeSize();
+}
+
+void Image::markModified() {
+    dataVersion++;
 }
 
-std::vector<float> Image::reconstructImageFromSpectrum() {
-    int imageSize = width * height;
+void Image::computeHistogram() {
+    evaluate();
 
-    fftw_complex* restored = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * imageSize);
-    fftw_plan bwPlan = fftw_plan_dft_2d(width, height, complexSpectrum, restored, FFTW_BACKWARD, FFTW_ESTIMATE);
+    histogram = Histogram::Compute(data.data(), data.size(), histogramBins);
+    histogramVersion = dataVersion;
+}
 
-    fftw_execute(bwPlan);
+const std::vector<int>& Image::getHistogram() {
+    evaluate();
 
-    // Rescale computed values
-    for (int i = 0; i < imageSize; i++) {
-        restored[i][0] = restored[i][0] / imageSize;
-        restored[i][1] = restored[i][1] / imageSize;
+    if (histogramVersion != dataVersion) {
+        computeHistogram();
     }
 
-    // Save magnitude to image
-    std::vector<float> restoredImage(imageSize);
-    for (int i = 0; i < imageSize; i++) {
-        double re = restored[i][0];
-        double im = restored[i][1];
-        double mag = sqrt(re * re + im * im);
+    return histogram;
+}
+
+const std::vector<float>& Image::getCDF() {
+    evaluate();
 
-        restoredImage[i] = (float)mag;
+    if (cdfVersion != dataVersion) {
+        computeCDF();
     }
 
-    fftw_destroy_plan(bwPlan);
-    fftw_free(restored);
+    return CDF;
+}
 
-    return restoredImage;
+void Image::setHistogramBins(int bins) {
+    bins = std::max(bins, 2);
+    if (bins == histogramBins) {
+        return;
+    }
+
+    histogramBins = bins;
+    histogramVersion = 0;
+    cdfVersion = 0;
 }
 
-void Image::negative(OperationDataSource dataSourceType) {
-    std::vector<float>& imageData = dataSourceType == Image::OperationDataSource::IMAGE ? data : spectrum;
+void Image::setAdaptiveEqualizationTiles(int tilesX, int tilesY) {
+    adaptiveTilesX = std::max(tilesX, 1);
+    adaptiveTilesY = std::max(tilesY, 1);
+}
 
-    std::for_each(
-        std::execution::par_unseq,
-        imageData.begin(),
-        imageData.end(),
-        [](auto&& item) {
-            item = 1 - item;
-        }
-    );
+void Image::computeCDF() {
+    CDF = Histogram::Cumulative(getHistogram());
+    cdfVersion = dataVersion;
 }
 
-void Image::threshold(float value, OperationDataSource dataSourceType) {
-    std::vector<float>& imageData = dataSourceType == Image::OperationDataSource::IMAGE ? data : spectrum;
+void Image::computeSpectrum(SpectrumMode mode, int threads) {
+    evaluate();
 
-    std::for_each(
-        std::execution::par_unseq,
-        imageData.begin(),
-        imageData.end(),
-        [value](auto&& item) {
-            item = item < value ? 0.0f : 1.0f;
+    freeSpectrum();
+    spectrumMode = mode;
+    spectrumVersion = dataVersion;
+
+    if (mode == SpectrumMode::REAL_FLOAT) {
+        computeHalfSpectrum(threads);
+        return;
+    }
+
+    const size_t imageSize = planeSize();
+    const size_t totalSize = imageSize * channels;
+
+    fftw_complex* sourceImage = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * totalSize);
+    complexSpectrum = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * totalSize);
+
+    // All planes are transformed by one batched plan
+    fftw_plan fwPlan = FFTPlans::GetDoubleMany(width, height, channels, FFTPlans::Direction::Forward, FFTPlans::Domain::Complex, sourceImage, complexSpectrum, threads);
+
+    Utils::ParallelBands(height * channels, [&](int begin, int end) {
+        for (size_t i = (size_t)begin * width; i < (size_t)end * width; i++) {
+            sourceImage[i][0] = (double)data[i];
+            sourceImage[i][1] = 0.0;
         }
-    );
+    });
+
+    fftw_execute_dft(fwPlan, sourceImage, complexSpectrum);
+    fftw_free(sourceImage);
+
+    
+    // Modify generated complex spectrum to be able to display it
+    spectrum.resize(totalSize);
+    for (int c = 0; c < channels; c++) {
+        Spectrum::LogMagnitude(complexSpectrum + c * imageSize, width, height, spectrum.data() + c * imageSize);
+    }
+
+    //const double factor = log(1.0 + maximalMagnitude);
 }
 
-void Image::brightness(float value, OperationDataSource dataSourceType) {
-    std::vector<float>& imageData = dataSourceType == Image::OperationDataSource::IMAGE ? data : spectrum;
+void Image::computeHalfSpectrum(int threads) {
+    const size_t imageSize = planeSize();
+    const size_t halfSize = (size_t)height * (width / 2 + 1);
 
-    std::for_each(
-        std::execution::par_unseq,
-        imageData.begin(),
-        imageData.end(),
-        [value](auto&& item) {
-            item = std::clamp(item + value, 0.0f, 1.0f);
-        }
-    );
+    halfSpectrum = fftwf_alloc_complex(halfSize * channels);
+
+    // Out of place real-to-complex transform keeps input intact, so image planes are transformed directly
+    fftwf_plan fwPlan = FFTPlans::GetFloatMany(width, height, channels, FFTPlans::Direction::Forward, FFTPlans::Domain::Real, data.data(), halfSpectrum, threads);
+    fftwf_execute_dft_r2c(fwPlan, data.data(), halfSpectrum);
+
+    spectrum.resize(imageSize * channels);
+    for (int c = 0; c < channels; c++) {
+        Spectrum::LogMagnitudeHalf(halfSpectrum + c * halfSize, width, height, spectrum.data() + c * imageSize);
+    }
 }
 
-void Image::contrast(float value, OperationDataSource dataSourceType) {
-    std::vector<float>& imageData = dataSourceType == Image::OperationDataSource::IMAGE ? data : spectrum;
+void Image::filterSpectrum(const Spectrum::Filter& filter, bool updateDisplay) {
+    if (complexSpectrum == nullptr && halfSpectrum == nullptr) {
+        std::cout << "Spectrum has to be computed before filtering" << std::endl;
+        return;
+    }
 
-    std::for_each(
-        std::execution::par_unseq,
-        imageData.begin(),
-        imageData.end(),
-        [value](auto&& item) {
-            item = std::clamp(item * value, 0.0f, 1.0f);
+    updateSpectrum();
+
+    const size_t imageSize = planeSize();
+    const size_t halfSize = (size_t)height * (width / 2 + 1);
+
+    for (int c = 0; c < channels; c++) {
+        if (spectrumMode == SpectrumMode::REAL_FLOAT) {
+            Spectrum::ApplyFilterHalf(halfSpectrum + c * halfSize, width, height, filter);
+            if (updateDisplay) {
+                Spectrum::LogMagnitudeHalf(halfSpectrum + c * halfSize, width, height, spectrum.data() + c * imageSize);
+            }
+        } else {
+            Spectrum::ApplyFilter(complexSpectrum + c * imageSize, width, height, filter);
+            if (updateDisplay) {
+                Spectrum::LogMagnitude(complexSpectrum + c * imageSize, width, height, spectrum.data() + c * imageSize);
+            }
         }
-    );
+    }
 }
 
-void Image::gammaCorrection(float value, OperationDataSource dataSourceType) {
-    std::vector<float>& imageData = dataSourceType == Image::OperationDataSource::IMAGE ? data : spectrum;
+void Image::updateSpectrum(int threads) {
+    evaluate();
 
-    std::for_each(
-        std::execution::par_unseq,
-        imageData.begin(),
-        imageData.end(),
-        [value](auto&& item) {
-            item = std::clamp(std::powf(item, value), 0.0f, 1.0f);
-        }
-    );
+    if (spectrumVersion != dataVersion) {
+        computeSpectrum(spectrumMode, threads);
+    }
+}
+
+void Image::freeSpectrum() {
+    if (complexSpectrum != nullptr) {
+        fftw_free(complexSpectrum);
+        complexSpectrum = nullptr;
+    }
+    if (halfSpectrum != nullptr) {
+        fftwf_free(halfSpectrum);
+        halfSpectrum = nullptr;
+    }
 }
 
-void Image::quantization(int value, OperationDataSource dataSourceType) {
-    std::vector<float>& imageData = dataSourceType == Image::OperationDataSource::IMAGE ? data : spectrum;
+std::vector<float> Image::reconstructImageFromSpectrum(int threads) {
+    updateSpectrum(threads);
 
-    std::for_each(
+    const size_t imageSize = planeSize();
+    const size_t totalSize = imageSize * channels;
+
+    if (spectrumMode == SpectrumMode::REAL_FLOAT) {
+        const size_t halfSize = (size_t)height * (width / 2 + 1) * channels;
+        std::vector<float> restoredImage(totalSize);
+
+        // Multidimensional complex-to-real transform always destroys its input, so it works on a copy
+        fftwf_complex* input = fftwf_alloc_complex(halfSize);
+        std::copy(&halfSpectrum[0][0], &halfSpectrum[0][0] + 2 * halfSize, &input[0][0]);
+
+        fftwf_plan bwPlan = FFTPlans::GetFloatMany(width, height, channels, FFTPlans::Direction::Backward, FFTPlans::Domain::Real, input, restoredImage.data(), threads);
+        fftwf_execute_dft_c2r(bwPlan, input, restoredImage.data());
+        fftwf_free(input);
+
+        // Result is real by construction, only rescaling is needed
+        const float scale = 1.0f / (float)imageSize;
+        std::for_each(
+            std::execution::par_unseq,
+            restoredImage.begin(),
+            restoredImage.end(),
+            [scale](float& value) { value *= scale; }
+        );
+
+        return restoredImage;
+    }
+
+    fftw_complex* restored = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * totalSize);
+    fftw_plan bwPlan = FFTPlans::GetDoubleMany(width, height, channels, FFTPlans::Direction::Backward, FFTPlans::Domain::Complex, complexSpectrum, restored, threads);
+
+    fftw_execute_dft(bwPlan, complexSpectrum, restored);
+
+    // Rescale computed values and save magnitude to image
+    const double pixels = (double)imageSize;
+    std::vector<float> restoredImage(totalSize);
+    std::transform(
         std::execution::par_unseq,
-        imageData.begin(),
-        imageData.end(),
-        [value](auto&& item) {
-            item = std::clamp((std::floor(item * value) / value), 0.0f, 1.0f);
+        restored,
+        restored + totalSize,
+        restoredImage.begin(),
+        [pixels](const fftw_complex& value) {
+            double re = value[0] / pixels;
+            double im = value[1] / pixels;
+            return (float)sqrt(re * re + im * im);
         }
     );
-}
 
-void Image::histogramEqualization(OperationDataSource dataSourceType) {
-    std::vector<float>& imageData = dataSourceType == Image::OperationDataSource::IMAGE ? data : spectrum;
+    fftw_free(restored);
 
-    for (int i = 0; i < imageData.size(); i++) {
-        imageData[i] = std::clamp(CDF[imageData[i] * 255], 0.0f, 1.0f);
-    }
+    return restoredImage;
 }
 
 void Image::Convolute(Kernel& kernel, Kernel::Type type, std::vector<float>& destination) {
+    evaluate();
+
+    std::vector<float> xDim;
+    std::vector<float> yDim;
+    Convolution::Algorithm algorithm = Convolution::Algorithm::Direct;
+
+    // Algorithm is chosen once for all planes
     switch (type) {
         case Kernel::Type::Kernel_1D: {
-            std::vector<float> xDim;
-            std::vector<float> yDim;
             kernel.SplitInto1DKernels(xDim, yDim);
-
-            std::vector<float> tmpData;
-            Convolute1D(xDim, yDim, data, tmpData, Kernel::Direction::Dir_X);
-            Convolute1D(xDim, yDim, tmpData, destination, Kernel::Direction::Dir_Y);
+            algorithm = Convolution::Algorithm::Separable;
             break;
         } case Kernel::Type::Kernel_2D: {
-            Convolute2D(kernel, destination);
+            algorithm = Convolution::Algorithm::Direct;
+            break;
+        } case Kernel::Type::Kernel_FFT: {
+            algorithm = Convolution::Algorithm::FFT;
+            break;
+        } case Kernel::Type::Kernel_Auto: {
+            bool separable = kernel.TrySplitInto1DKernels(xDim, yDim);
+            algorithm = Convolution::ChooseAlgorithm(kernel.size, separable, width, height);
             break;
         }
     }
+
+    filterPlanes(destination, [&](const float* source, float* planeDestination, int) {
+        switch (algorithm) {
+        case Convolution::Algorithm::Direct:
+            Convolute2D(kernel, source, planeDestination);
+            break;
+        case Convolution::Algorithm::Separable:
+            Convolution::Separable(source, planeDestination, width, height, xDim, yDim);
+            break;
+        case Convolution::Algorithm::FFT:
+            Convolution::FFT(source, planeDestination, width, height, kernel.values, kernel.size);
+            break;
+        }
+    });
 }
 
-void Image::Convolute2D(Kernel& kernel, std::vector<float>& destination) {
-    int center = kernel.size / 2;
-    destination.resize(width * height);
+void Image::Convolute2D(Kernel& kernel, const float* source, float* destination) {
+    Convolution::Direct(source, destination, width, height, kernel.values, kernel.size);
+}
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            float newPixelValue = 0.0f;
-            
-            for (int kY = 0; kY < kernel.size; kY++) {
-                for (int kX = 0; kX < kernel.size; kX++) {
-                    int xFinal = std::clamp(x + (kX - center), 0, width - 1);
-                    int yFinal = std::clamp(y + (kY - center), 0, height - 1);
+void Image::ApplyRecursiveGaussFilter(const float sigma, std::vector<float>& outData) {
+    evaluate();
 
-                    newPixelValue += data[Index2Dto1D(xFinal, yFinal)] * kernel.values[kX + kY * kernel.size];
-                }
-            }
+    filterPlanes(outData, [&](const float* source, float* destination, int) {
+        Convolution::RecursiveGauss(source, destination, width, height, sigma);
+    });
+}
+
+void Image::ApplyBilateralFilter(
+    const float spatialSigma,
+    const float brightnessSigma,
+    std::vector<float>& outData,
+    BilateralMethod method
+) {
+    evaluate();
 
-            destination[Index2Dto1D(x, y)] = newPixelValue;
+    filterPlanes(outData, [&](const float* source, float* destination, int) {
+        if (method == BilateralMethod::CONSTANT_TIME) {
+            Bilateral::ConstantTime(source, source, destination, width, height, spatialSigma, brightnessSigma);
+            return;
         }
-    }
+
+        Bilateral::Exact(source, source, destination, width, height, spatialSigma, brightnessSigma);
+    });
 }
 
-void Image::Convolute1D(
-    std::vector<float>& xDim,
-    std::vector<float>& yDim,
-    std::vector<float>& source,
-    std::vector<float>& destination,
-    Kernel::Direction direction 
+bool Image::ApplyJointBilateralFilter(
+    Image& guide,
+    const float spatialSigma,
+    const float brightnessSigma,
+    std::vector<float>& outData,
+    BilateralMethod method
 ) {
-    int kernelSize = xDim.size();
-    int center = kernelSize / 2;
-    destination.resize(source.size());
+    if (guide.width != width || guide.height != height) {
+        std::cout << "Guide of bilateral filter must have the same size as image" << std::endl;
+        return false;
+    }
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            float newPixelValue = 0.0f;
+    evaluate();
+    guide.evaluate();
 
-            for (int i = 0; i < kernelSize; i++) {
-                int offset = i - center;
+    filterPlanes(outData, [&](const float* source, float* destination, int channel) {
+        const float* edges = guidePlane(guide, source, channel);
 
-                if (direction == Kernel::Direction::Dir_X) {
-                    int xFinal = std::clamp(x + offset, 0, width - 1);
-                    int yFinal = y;
+        if (method == BilateralMethod::CONSTANT_TIME) {
+            Bilateral::ConstantTime(source, edges, destination, width, height, spatialSigma, brightnessSigma);
+        } else {
+            Bilateral::Exact(source, edges, destination, width, height, spatialSigma, brightnessSigma);
+        }
+    });
 
-                    newPixelValue += source[Index2Dto1D(xFinal, yFinal)] * xDim[i];
-                } else {
-                    int xFinal = x;
-                    int yFinal = std::clamp(y + offset, 0, height - 1);
-    
-                    newPixelValue += source[Index2Dto1D(xFinal, yFinal)] * yDim[i];
-                }
-            }
+    return true;
+}
 
-            destination[Index2Dto1D(x, y)] = newPixelValue;
-        }
+bool Image::ApplyGuidedFilter(Image& guide, int radius, float epsilon, std::vector<float>& outData) {
+    if (guide.width != width || guide.height != height) {
+        std::cout << "Guide of guided filter must have the same size as image" << std::endl;
+        return false;
     }
+
+    evaluate();
+    guide.evaluate();
+
+    filterPlanes(outData, [&](const float* source, float* destination, int channel) {
+        Guided::Filter(source, guidePlane(guide, source, channel), destination, width, height, radius, epsilon);
+    });
+    return true;
 }
 
-void Image::ApplyBilateralFilter(
-    const float spatialSigma,
-    const float brightnessSigma,
-    std::vector<float>& outData
-) {
-    outData.resize(data.size());
-
-    int filterSize = 6 * spatialSigma + 1;
-    int center = filterSize / 2;
-
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            float intensitySum = 0.0f;
-            float normalization = 0.0f;
-
-            for (int fy = 0; fy < filterSize; fy++) {
-                int yOffset = fy - center;
-                for (int fx = 0; fx < filterSize; fx++) {
-                    int xOffset = fx - center;
-
-                    int imageFilterPosY = std::clamp(y + yOffset, 0, height - 1);
-                    int imageFilterPosX = std::clamp(x + xOffset, 0, width - 1);
-
-                    // Get distance from center of "kernel"
-                    float deltaX = (float)(xOffset - fx) / (float)filterSize;
-                    float deltaY = (float)(yOffset - fy) / (float)filterSize;
-                    float distFromCenter = sqrtf((deltaX * deltaX) + (deltaY * deltaY));
-
-                    // Get difference in intensities with log scaling
-                    float intensityDiff = logf(data[y * width + x]) - logf(data[imageFilterPosY * width + imageFilterPosX]);
-                    
-                    // Eval gaussians
-                    float distGauss = Utils::GaussianValue(distFromCenter, spatialSigma);
-                    float intensityGauss = Utils::GaussianValue(intensityDiff, brightnessSigma);
-
-                    // Calc intesity and store that for later usage
-                    float intensity = distGauss * intensityGauss * data[imageFilterPosY * width + imageFilterPosX];
-                    intensitySum += intensity;
-                    normalization += (distGauss * intensityGauss);
-                }
-            }
+void Image::ApplyAdaptiveThreshold(AdaptiveThresholdMethod method, int radius, float k, std::vector<float>& outData) {
+    evaluate();
 
-            // Save normalized value
-            outData[y * width + x] = intensitySum / normalization;
+    filterPlanes(outData, [&](const float* source, float* destination, int) {
+        SummedAreaTable table;
+        table.build(source, width, height, true);
+
+        if (method == AdaptiveThresholdMethod::SAUVOLA) {
+            // Deviation of data in <0, 1> is at most 0.5
+            table.sauvolaThreshold(source, radius, k, 0.5f, destination);
+        } else {
+            table.niblackThreshold(source, radius, k, destination);
         }
-    }
+    });
 }
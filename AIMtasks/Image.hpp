@@ -1,16 +1,21 @@
 ﻿#pragma once
 
+#include <cstdint>
+#include <functional>
+#include <string>
 #include <vector>
 
 #include <fftw3.h>
 
 #include "Kernel.hpp"
 #include "Utils.hpp"
+#include "Spectrum.hpp"
 
 /// <summary>
 /// Class representing image for purposes of AIM class. 
 /// 
-/// So far only grayscale images, it will be rewritten in future.
+/// Images are grayscale unless loaded with keepChannels, channels are stored as planes (see data), so every
+/// operation runs on contiguous plane of each channel and channels are processed in parallel.
 /// </summary>
 class Image {
 public:
@@ -20,12 +25,17 @@ public:
 	int height;
     /// <summary> Number of components in each pixel </summary>
 	int components;
+    /// <summary> Number of planes in data, 1 for grayscale images </summary>
+    int channels = 1;
 
     /// <summary> Quality of saved jpegs </summary>
     const int quality = 90;
 
     /// <summary>
     /// Enum representing possible monadic operations from Task I.
+    ///
+    /// ADAPTIVE_HISTOGRAM_EQUALIZATION is contrast limited adaptive equalization (see Clahe::Apply), its value
+    /// is clip limit and grid of tiles is set by setAdaptiveEqualizationTiles.
     /// </summary>
     enum class MonadicOperationType {
         NEGATIVE,
@@ -34,7 +44,16 @@ public:
         CONTRAST,
         GAMMA_CORRECTION,
         QUANTIZATION,
-        HISTOGRAM_EQUALIZATION
+        HISTOGRAM_EQUALIZATION,
+        ADAPTIVE_HISTOGRAM_EQUALIZATION
+    };
+
+    /// <summary>
+    /// Monadic operation with its parameter, element of operation chains.
+    /// </summary>
+    struct MonadicOperation {
+        MonadicOperationType type;
+        float value = 0.0f;
     };
 
     /// <summary>
@@ -45,57 +64,207 @@ public:
         SPECTRUM
     };
 
+    /// <summary>
+    /// Enum representing how spectrum is computed and stored.
+    /// 
+    /// COMPLEX_DOUBLE transforms image as complex double data and stores whole spectrum (16 B per pixel),
+    /// REAL_FLOAT uses single precision real-to-complex transform and stores only its Hermitian half
+    /// (width / 2 + 1 columns, about 4 B per pixel), the other half is mirrored when displayed.
+    /// </summary>
+    enum class SpectrumMode {
+        COMPLEX_DOUBLE,
+        REAL_FLOAT
+    };
+
+    /// <summary>
+    /// Enum representing algorithm of bilateral filter.
+    /// 
+    /// EXACT evaluates whole window for every pixel, CONSTANT_TIME approximates it in time independent
+    /// of window size (see Bilateral::ConstantTime for its accuracy).
+    /// </summary>
+    enum class BilateralMethod {
+        EXACT,
+        CONSTANT_TIME
+    };
+
+    /// <summary>
+    /// Enum representing local threshold formula of adaptive thresholding.
+    /// </summary>
+    enum class AdaptiveThresholdMethod {
+        NIBLACK,
+        SAUVOLA
+    };
+
+    /// <summary>
+    /// Interleaved view of planar data ((x + y * width) * channels + channel order of image files and most
+    /// libraries), values are accessed in planes directly, so no interleaved copy is made.
+    /// </summary>
+    struct InterleavedView {
+        float* planes;
+        int width;
+        int height;
+        int channels;
+
+        /// <summary> Value of channel of pixel (x, y) </summary>
+        float& operator()(int x, int y, int channel) const {
+            return planes[((size_t)channel * height + y) * width + x];
+        }
+
+        /// <summary> Value at index of interleaved buffer </summary>
+        float& operator[](size_t index) const {
+            return planes[(index % channels) * ((size_t)width * height) + index / channels];
+        }
+
+        /// <summary> Number of values of interleaved buffer </summary>
+        size_t size() const {
+            return (size_t)width * height * channels;
+        }
+    };
+
     /// <summary>
     /// Construct image from given path.
     /// </summary>
     /// <param name="path">Path to file with image to be loaded.</param>
-    Image(std::string path);
+    /// <param name="keepChannels">Whether to keep all channels instead of converting to luminance.</param>
+    Image(std::string path, bool keepChannels = false);
 
     /// <summary>
     /// Construct image from given data.
     /// </summary>
-    /// <param name="imageData">Vector of floats of image data.</param>
+    /// <param name="imageData">Vector of floats of image data (planes, their number is given by size).</param>
     /// <param name="path">Path to file where to be saved.</param>
     Image(std::vector<float>& imageData, std::string path, int width, int height, int components);
 
     ~Image();
 
     /// <summary>
-    /// Loads image from file given by path.
+    /// Loads image from file given by path, as luminance (colour images) or its first channel (gray with alpha)
+    /// unless all channels are kept.
     /// </summary>
     /// <param name="path">Path to image file.</param>
+    /// <param name="keepChannels">Whether to store every component of file as plane.</param>
     /// <returns>True on success.</returns>
-    bool load(std::string path);
+    bool load(std::string path, bool keepChannels = false);
 
+    /// <summary>
+    /// Number of values of one plane (width * height).
+    /// </summary>
+    size_t planeSize() const;
+
+    /// <summary>
+    /// Returns plane of given channel in data (recorded operations are not applied, see evaluate).
+    /// </summary>
+    /// <param name="channel">Index of channel</param>
+    float* plane(int channel);
 
     /// <summary>
-    /// Saves image data to file with same name as input with possibility of using a prefix.
+    /// Returns interleaved view of data (recorded operations are applied first).
+    /// </summary>
+    InterleavedView interleaved();
+
+    /// <summary>
+    /// Saves image data to file with same name as input with possibility of using a prefix, every plane
+    /// is saved as one component (grayscale images as single component).
     /// </summary>
     /// <param name="prefix">String to prepend before an output filename.</param>
     void save(std::string prefix = "", OperationDataSource dataSource = OperationDataSource::IMAGE);
 
     /// <summary>
-    /// Performs given operation on image with specified value when needed.
+    /// Records given operation with specified value (applied lazily, see queueOperation).
     /// </summary>
     /// <param name="operation">Type of operation to do.</param>
     /// <param name="value">Input value of operation</param>
-    void doOperation(MonadicOperationType operation, float value = 0.0f);
+    /// <param name="saveResult">Whether to save modified image right away.</param>
+    void doOperation(MonadicOperationType operation, float value = 0.0f, bool saveResult = true);
+
+    /// <summary>
+    /// Applies chain of point operations (all except histogram equalization) through lookup table.
+    ///
+    /// Data are quantized to codes of given depth, chain is evaluated once per code (see Monadic::Compile)
+    /// and codes are mapped by table, so cost does not depend on operations. Result is quantized to that depth.
+    /// </summary>
+    /// <param name="chain">Operations applied in order</param>
+    /// <param name="bits">Depth of codes, 8 or 16</param>
+    /// <returns>False when chain cannot be compiled or depth is not supported.</returns>
+    bool applyLookupTable(const std::vector<MonadicOperation>& chain, int bits = 8);
+
+    /// <summary>
+    /// Records monadic operation, data are not modified until pixels are needed (save, histogram, convolution,
+    /// filters, spectrum) or evaluate is called, so that only the final state of many tweaks is computed.
+    /// </summary>
+    /// <param name="operation">Type of operation to do.</param>
+    /// <param name="value">Input value of operation</param>
+    void queueOperation(MonadicOperationType operation, float value = 0.0f);
+
+    /// <summary>
+    /// Applies recorded operations to data: chain is simplified (Monadic::Simplify) and run fused
+    /// in one pass (Monadic::ApplyFused), adaptive equalizations run separately between fused parts.
+    /// Has to be called before data are accessed directly.
+    /// </summary>
+    void evaluate();
 
     /// <summary>
-    /// Compute images histogram.
+    /// Applies recorded operations and then given chain of operations fused in one pass over data.
+    /// </summary>
+    /// <param name="chain">Operations applied in order</param>
+    void applyOperations(const std::vector<MonadicOperation>& chain);
+
+    /// <summary>
+    /// Marks data as modified, so that derived data (histogram, CDF, spectrum) are recomputed when they are
+    /// needed next time. Has to be called after data are modified directly.
+    /// </summary>
+    void markModified();
+
+    /// <summary>
+    /// Compute images histogram (in parallel, see Histogram::Compute).
     /// </summary>
     void computeHistogram();
 
+    /// <summary>
+    /// Histogram of current data, counted only when it is stale (data were modified since it was counted).
+    /// </summary>
+    /// <returns>Counts of all bins</returns>
+    const std::vector<int>& getHistogram();
+
+    /// <summary>
+    /// CDF of current data, computed from histogram only when it is stale.
+    /// </summary>
+    /// <returns>Normalized cumulative histogram</returns>
+    const std::vector<float>& getCDF();
+
+    /// <summary>
+    /// Changes number of histogram bins, histogram and CDF are recomputed when needed. CDF of more bins
+    /// makes histogram equalization finer (e.g. 4096 or 65536 for 12-bit and 16-bit sources).
+    /// </summary>
+    /// <param name="bins">Number of bins, 256 by default</param>
+    void setHistogramBins(int bins);
+
+    /// <summary>
+    /// Changes grid of tiles used by adaptive histogram equalization.
+    /// </summary>
+    /// <param name="tilesX">Number of tile columns, 8 by default</param>
+    /// <param name="tilesY">Number of tile rows, 8 by default</param>
+    void setAdaptiveEqualizationTiles(int tilesX, int tilesY);
+
     /// <summary>
     /// Computes spectrum of image with usage of Fourier Transform.
     /// </summary>
-    void computeSpectrum();
+    /// <param name="mode">Precision and storage of computed spectrum.</param>
+    /// <param name="threads">Number of FFTW threads, 0 uses global setting (FFTPlans::SetThreads).</param>
+    void computeSpectrum(SpectrumMode mode = SpectrumMode::COMPLEX_DOUBLE, int threads = 0);
+
+    /// <summary>
+    /// Filters complex spectrum (of either mode) in place, so that filtered image can be reconstructed.
+    /// </summary>
+    /// <param name="filter">Frequency domain filter.</param>
+    /// <param name="updateDisplay">Whether to regenerate displayed spectrum from filtered one.</param>
+    void filterSpectrum(const Spectrum::Filter& filter, bool updateDisplay = true);
 
     /// <summary>
     /// Do convolution with given kernel with specified method.
     /// </summary>
     /// <param name="kernel"> Kernel to convolute with. </param>
-    /// <param name="type"> 2D or lineary separated 2D. </param>
+    /// <param name="type"> 2D, lineary separated 2D, FFT or automatically chosen. </param>
     /// <param name="destination"> Vector where to save convoluted image. </param>
     void Convolute(Kernel& kernel, Kernel::Type type, std::vector<float>& destination);
 
@@ -105,12 +274,58 @@ public:
     /// <param name="spatialSigma"> Parameter of distance influence </param>
     /// <param name="brightnessSigma"> Parameter of color difference influence </param>
     /// <param name="outData"> Vector where to save filtered data </param>
+    /// <param name="method"> Exact or constant time algorithm </param>
     void ApplyBilateralFilter(
         const float spatialSigma,
         const float brightnessSigma,
-        std::vector<float>& outData
+        std::vector<float>& outData,
+        BilateralMethod method = BilateralMethod::EXACT
     );
 
+    /// <summary>
+    /// Applies joint (cross) bilateral filtering, data of this image are smoothed along edges of guide.
+    /// </summary>
+    /// <param name="guide"> Image of the same size whose edges are preserved </param>
+    /// <param name="spatialSigma"> Parameter of distance influence </param>
+    /// <param name="brightnessSigma"> Parameter of color difference influence </param>
+    /// <param name="outData"> Vector where to save filtered data </param>
+    /// <param name="method"> Exact or constant time algorithm </param>
+    /// <returns> False when sizes of images differ </returns>
+    bool ApplyJointBilateralFilter(
+        Image& guide,
+        const float spatialSigma,
+        const float brightnessSigma,
+        std::vector<float>& outData,
+        BilateralMethod method = BilateralMethod::EXACT
+    );
+
+    /// <summary>
+    /// Applies guided filter (see Guided::Filter), edge preserving smoothing in time independent of radius.
+    /// </summary>
+    /// <param name="guide"> Image of the same size whose edges are preserved (may be this image) </param>
+    /// <param name="radius"> Radius of square window </param>
+    /// <param name="epsilon"> Regularization, larger values smooth stronger edges </param>
+    /// <param name="outData"> Vector where to save filtered data </param>
+    /// <returns> False when sizes of images differ </returns>
+    bool ApplyGuidedFilter(Image& guide, int radius, float epsilon, std::vector<float>& outData);
+
+    /// <summary>
+    /// Binarizes image by threshold computed from mean and deviation of window around each pixel
+    /// (see SummedAreaTable), cost does not depend on window size.
+    /// </summary>
+    /// <param name="method"> Niblack or Sauvola formula </param>
+    /// <param name="radius"> Radius of square window </param>
+    /// <param name="k"> Weight of deviation (Niblack, e.g. -0.2) or sensitivity (Sauvola, e.g. 0.34) </param>
+    /// <param name="outData"> Vector where to save binary data </param>
+    void ApplyAdaptiveThreshold(AdaptiveThresholdMethod method, int radius, float k, std::vector<float>& outData);
+
+    /// <summary>
+    /// Applies Gaussian blur by recursive filter, its cost does not depend on sigma (suitable for large sigmas).
+    /// </summary>
+    /// <param name="sigma"> Standard deviation of Gaussian in pixels </param>
+    /// <param name="outData"> Vector where to save blurred data </param>
+    void ApplyRecursiveGaussFilter(const float sigma, std::vector<float>& outData);
+
     /// <summary>
     /// Converts 2D index to 1D index to array (using internal image width).
     /// </summary>
@@ -123,30 +338,57 @@ public:
 
     /// <summary>
     /// Replaces image content with reconstruction from spectrum (possibly modified) using Inverse FT.
+    /// 
+    /// Uses inverse transform matching mode of last computed spectrum, spectrum is computed again in that mode
+    /// when data were modified since (discarding its filtering).
     /// </summary>
+    /// <param name="threads">Number of FFTW threads, 0 uses global setting (FFTPlans::SetThreads).</param>
     /// <returns></returns>
-    std::vector<float> reconstructImageFromSpectrum();
+    std::vector<float> reconstructImageFromSpectrum(int threads = 0);
 
-    /// <summary> Image data representing each pixel as float <0,1> in grayscale </summary>
+    /// <summary> Image data representing each pixel as float <0,1> in planes of channels one after another (without recorded operations, see evaluate), call markModified after modifying them </summary>
     std::vector<float> data;
 private:
     /// <summary> </summary>
     std::string path;
 
 
+    /// <summary> Operations recorded but not yet applied to data </summary>
+    std::vector<MonadicOperation> pendingOperations;
+
+    /// <summary> Version of data, increased by every modification </summary>
+    uint64_t dataVersion = 1;
+    /// <summary> Version of data histogram belongs to, it is stale when it differs from dataVersion (0 - never computed) </summary>
+    uint64_t histogramVersion = 0;
+    /// <summary> Version of data CDF belongs to </summary>
+    uint64_t cdfVersion = 0;
+    /// <summary> Version of data spectrum belongs to </summary>
+    uint64_t spectrumVersion = 0;
+
+    /// <summary> Number of bins of histogram and CDF </summary>
+    int histogramBins = 256;
     /// <summary> Histogram of image </summary>
     std::vector<int> histogram;
     /// <summary> CDF of image computed from histogram </summary>
     std::vector<float> CDF;
 
+    /// <summary> Number of tile columns of adaptive histogram equalization </summary>
+    int adaptiveTilesX = 8;
+    /// <summary> Number of tile rows of adaptive histogram equalization </summary>
+    int adaptiveTilesY = 8;
+
     /// <summary> Spectrum of image modified that it is possible to show it to user </summary>
     std::vector<float> spectrum;
     /// <summary> Spectrum of image created by FT </summary>
     fftw_complex* complexSpectrum = nullptr;
+    /// <summary> Hermitian half of spectrum created by real-to-complex FT (height rows of width / 2 + 1) </summary>
+    fftwf_complex* halfSpectrum = nullptr;
+    /// <summary> Mode in which current spectrum was computed </summary>
+    SpectrumMode spectrumMode = SpectrumMode::COMPLEX_DOUBLE;
 
 
     /// <summary>
-    /// Converts loaded RGB image to grayscale only.
+    /// Converts loaded RGB image (of given number of components) to grayscale only (see Color::Decode).
     /// </summary>
     /// <param name="image">Input array of loaded RGB image pixels.</param>
     /// <param name="nu">Width of image</param>
@@ -154,64 +396,52 @@ private:
     void RGBToLuminanceImage(unsigned char* image, int nu, int nv);
     
     /// <summary>
-    /// Compute images CDF from its histogram.
+    /// Applies chain of operations without adaptive equalization fused in one pass, histogram counted before chain
+    /// is carried through it when chain equalizes (see Histogram::Remap).
     /// </summary>
-    void computeCDF();
-
-    /// <summary>
-    /// Compute histogram of image.
-    /// </summary>
-    void negative(OperationDataSource dataSource = Image::OperationDataSource::IMAGE);
+    void applyFused(const std::vector<MonadicOperation>& chain);
 
     /// <summary>
-    /// Thresholds value of image pixels based on given value.
-    /// </summary>
-    /// <param name="value">Input value of operation</param>
-    void threshold(float value, OperationDataSource dataSource = Image::OperationDataSource::IMAGE);
-
-    /// <summary>
-    /// Modify image brightness by given value.
+    /// Compute images CDF from its histogram.
     /// </summary>
-    /// <param name="value">Input value of operation</param>
-    void brightness(float value, OperationDataSource dataSource = Image::OperationDataSource::IMAGE);
+    void computeCDF();
 
     /// <summary>
-    /// Modify image contrast by given value.
+    /// Computes spectrum again in mode of the last one when it is stale.
     /// </summary>
-    /// <param name="value">Input value of operation</param>
-    void contrast(float value, OperationDataSource dataSource = Image::OperationDataSource::IMAGE);
+    void updateSpectrum(int threads = 0);
 
     /// <summary>
-    /// Do gamma corection of image.
+    /// Computes Hermitian half of spectrum by single precision real-to-complex FT and expands it to displayed spectrum.
     /// </summary>
-    /// <param name="value">Input value of operation</param>
-    void gammaCorrection(float value, OperationDataSource dataSource = Image::OperationDataSource::IMAGE);
+    void computeHalfSpectrum(int threads);
 
     /// <summary>
-    /// Reduce number of color levels in image to given value.
+    /// Frees stored complex spectra.
     /// </summary>
-    /// <param name="value">Input value of operation</param>
-    void quantization(int value, OperationDataSource dataSource = Image::OperationDataSource::IMAGE);
+    void freeSpectrum();
 
     /// <summary>
-    /// Equalize image histogram.
+    /// Do convolution (classical 2D) of source plane with given kernel (see Convolution::Direct).
     /// </summary>
-    void histogramEqualization(OperationDataSource dataSource = Image::OperationDataSource::IMAGE);
+    void Convolute2D(Kernel& kernel, const float* source, float* destination);
 
     /// <summary>
-    /// Do convolution (classical 2D) with given kernel
+    /// Runs filter(source, destination, channel) for every plane, channels in parallel. Source points to plane
+    /// in data and destination to the same plane of output, so planes are filtered without copies.
     /// </summary>
-    void Convolute2D(Kernel& kernel, std::vector<float>& destination);
+    /// <param name="destination">Vector where to save filtered planes.</param>
+    /// <param name="filter">Filter of one plane of planeSize() values.</param>
+    void filterPlanes(
+        std::vector<float>& destination,
+        const std::function<void(const float*, float*, int)>& filter
+    );
 
     /// <summary>
-    /// Do convolution with given gernel (split 2D kernel into two 1D for better performance)
+    /// Returns plane of guide used for given channel of this image: source itself when image guides itself,
+    /// the only plane of grayscale guide, otherwise plane of the same channel (first one when numbers
+    /// of channels differ).
     /// </summary>
-    void Convolute1D(
-        std::vector<float>& xDim,
-        std::vector<float>& yDim,
-        std::vector<float>& source,
-        std::vector<float>& destination,
-        Kernel::Direction direction
-    );
+    const float* guidePlane(Image& guide, const float* source, int channel) const;
 };
 
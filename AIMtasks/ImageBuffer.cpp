@@ -0,0 +1,85 @@
+#include <algorithm>
+
+#include "ImageBuffer.hpp"
+#include "Utils.hpp"
+
+/// <summary>
+/// Number of float values in one aligned block.
+/// </summary>
+static const int BlockValues = (int)(ImageBuffer::Alignment / sizeof(float));
+
+/// <summary>
+/// Rounds value up to whole aligned blocks.
+/// </summary>
+static inline int RoundToBlocks(int value) {
+    return (value + BlockValues - 1) / BlockValues * BlockValues;
+}
+
+ImageBuffer::ImageBuffer(int width, int height, int apron) {
+    allocate(width, height, apron);
+}
+
+ImageBuffer::ImageBuffer(const float* data, int width, int height, int apron) {
+    assign(data, width, height, apron);
+}
+
+void ImageBuffer::allocate(int width, int height, int apron) {
+    this->width = width;
+    this->height = height;
+    this->apron = std::max(apron, 0);
+
+    // Padding on both sides is rounded to whole blocks, so that pixel (0, y) is aligned and vectors
+    // shifted by apron from the last vector of row stay inside padding
+    leftPadding = RoundToBlocks(this->apron);
+    stride = (size_t)RoundToBlocks(width) + 2 * (size_t)leftPadding;
+
+    const size_t size = stride * ((size_t)height + 2 * this->apron);
+    if (size > capacity) {
+        storage.reset(static_cast<float*>(::operator new[](size * sizeof(float), std::align_val_t(Alignment))));
+        capacity = size;
+    }
+
+    origin = storage.get() + (size_t)this->apron * stride + leftPadding;
+}
+
+void ImageBuffer::assign(const float* data, int width, int height, int apron) {
+    allocate(width, height, apron);
+
+    Utils::ParallelBands(height, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            std::copy_n(data + (size_t)y * width, width, row(y));
+        }
+    });
+
+    replicateApron();
+}
+
+void ImageBuffer::replicateApron() {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    const size_t rightPadding = stride - leftPadding - width;
+
+    Utils::ParallelBands(height, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            float* values = row(y);
+            std::fill_n(values - leftPadding, leftPadding, values[0]);
+            std::fill_n(values + width, rightPadding, values[width - 1]);
+        }
+    });
+
+    // Apron rows are copies of whole border rows, their apron included
+    for (int a = 1; a <= apron; a++) {
+        std::copy_n(row(0) - leftPadding, stride, row(-a) - leftPadding);
+        std::copy_n(row(height - 1) - leftPadding, stride, row(height - 1 + a) - leftPadding);
+    }
+}
+
+void ImageBuffer::copyTo(float* data) const {
+    Utils::ParallelBands(height, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            std::copy_n(row(y), width, data + (size_t)y * width);
+        }
+    });
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+/// <summary>
+/// Plane of float values with rows aligned to 64 bytes and optional apron of replicated border pixels.
+///
+/// Rows are stride values apart (multiple of 16 values, wider than image when padded), pixel (0, y) of every
+/// row is aligned. Apron of given size surrounds image on all sides and holds copies of the nearest border
+/// pixel, so filters with radius up to apron read pixels (x, y) for x, y in <-apron, size + apron) without
+/// clamping. Rows are padded to whole 64 B blocks on the right as well, vector of up to 16 values starting
+/// at multiple of its width below width and shifted by at most apron never leaves its row.
+/// Buffer is move only.
+/// </summary>
+class ImageBuffer {
+public:
+    /// <summary> Alignment of rows in bytes </summary>
+    static constexpr size_t Alignment = 64;
+
+    /// <summary> Width of image </summary>
+    int width = 0;
+    /// <summary> Height of image </summary>
+    int height = 0;
+    /// <summary> Number of replicated pixels around image </summary>
+    int apron = 0;
+    /// <summary> Distance of rows in values </summary>
+    size_t stride = 0;
+
+    ImageBuffer() = default;
+
+    /// <summary>
+    /// Allocates buffer of given size (see allocate).
+    /// </summary>
+    ImageBuffer(int width, int height, int apron = 0);
+
+    /// <summary>
+    /// Allocates buffer for packed data (height rows of width values) and copies them in (see assign).
+    /// </summary>
+    ImageBuffer(const float* data, int width, int height, int apron = 0);
+
+    /// <summary>
+    /// Allocates buffer of given size, content is undefined. Memory is reused when layout does not change.
+    /// </summary>
+    /// <param name="width">Width of image</param>
+    /// <param name="height">Height of image</param>
+    /// <param name="apron">Number of replicated pixels around image</param>
+    void allocate(int width, int height, int apron = 0);
+
+    /// <summary>
+    /// Allocates buffer for packed data, copies them in and replicates apron, rows run in parallel.
+    /// </summary>
+    /// <param name="data">Height rows of width values</param>
+    /// <param name="width">Width of image</param>
+    /// <param name="height">Height of image</param>
+    /// <param name="apron">Number of replicated pixels around image</param>
+    void assign(const float* data, int width, int height, int apron = 0);
+
+    /// <summary>
+    /// Fills apron (and padding of rows) by copies of border pixels, has to be called after image is modified.
+    /// </summary>
+    void replicateApron();
+
+    /// <summary>
+    /// Copies image without apron to packed data (height rows of width values).
+    /// </summary>
+    void copyTo(float* data) const;
+
+    /// <summary>
+    /// Pointer to pixel (0, y), y may lie in apron.
+    /// </summary>
+    inline float* row(int y) {
+        return origin + (ptrdiff_t)y * (ptrdiff_t)stride;
+    }
+
+    inline const float* row(int y) const {
+        return origin + (ptrdiff_t)y * (ptrdiff_t)stride;
+    }
+
+private:
+    /// <summary> Frees storage allocated with alignment of rows </summary>
+    struct AlignedDelete {
+        void operator()(float* values) const {
+            ::operator delete[](values, std::align_val_t(Alignment));
+        }
+    };
+
+    /// <summary> Whole buffer, height + 2 * apron rows of stride values </summary>
+    std::unique_ptr<float[], AlignedDelete> storage;
+    /// <summary> Number of allocated values </summary>
+    size_t capacity = 0;
+    /// <summary> Pixel (0, 0) within storage </summary>
+    float* origin = nullptr;
+    /// <summary> Number of values in front of pixel (0, y) in its row, apron rounded up to alignment </summary>
+    int leftPadding = 0;
+};
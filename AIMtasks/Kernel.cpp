@@ -47,7 +47,7 @@ void Kernel::CreateGauss(double sigma)
 void Kernel::CreateFromValues(std::vector<float>& values)
 {
 	this->size = static_cast<int>(sqrt(values.size()));
-	std::copy(values.begin(), values.end(), this->values.begin());
+	this->values = values;
 }
 
 void Kernel::SplitInto1DKernels(std::vector<float>& xDim, std::vector<float>& yDim)
@@ -79,6 +79,47 @@ void Kernel::SplitInto1DKernels(std::vector<float>& xDim, std::vector<float>& yD
     }
 }
 
+bool Kernel::TrySplitInto1DKernels(std::vector<float>& xDim, std::vector<float>& yDim, float tolerance)
+{
+    // Rank one kernel is outer product of its row and column going through the largest value
+    int pivotX = 0;
+    int pivotY = 0;
+    float maxValue = 0.0f;
+
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            if (fabs(values[Index2Dto1D(x, y)]) > maxValue) {
+                maxValue = fabs(values[Index2Dto1D(x, y)]);
+                pivotX = x;
+                pivotY = y;
+            }
+        }
+    }
+
+    if (maxValue == 0.0f) {
+        return false;
+    }
+
+    float pivot = values[Index2Dto1D(pivotX, pivotY)];
+    xDim.resize(size);
+    yDim.resize(size);
+
+    for (int i = 0; i < size; i++) {
+        xDim[i] = values[Index2Dto1D(i, pivotY)];
+        yDim[i] = values[Index2Dto1D(pivotX, i)] / pivot;
+    }
+
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            if (fabs(values[Index2Dto1D(x, y)] - xDim[x] * yDim[y]) > tolerance * maxValue) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
 void Kernel::Print()
 {
     for (int i = 0; i < size; i++) {
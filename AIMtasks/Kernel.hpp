@@ -8,7 +8,11 @@ public:
 	/// <summary> Used for managing Convolute function - use normal 2D kernel or lineary separate it </summary>
 	enum class Type {
 		Kernel_1D,
-		Kernel_2D
+		Kernel_2D,
+		/// <summary> Convolution in frequency domain (FFT of image tiles) </summary>
+		Kernel_FFT,
+		/// <summary> Pick direct, separable or FFT convolution by cost model </summary>
+		Kernel_Auto
 	};
 	/// <summary> Direction in lineary separable kernels </summary>
 	enum class Direction {
@@ -37,6 +41,12 @@ public:
 	/// <summary> Splits current 2D kernel into two 1D ones </summary>
 	void SplitInto1DKernels(std::vector<float>& xDim, std::vector<float>& yDim);
 
+	/// <summary>
+	/// Splits kernel into two 1D ones without normalization, so that value (x, y) = xDim[x] * yDim[y].
+	/// Returns false when kernel is not separable (not of rank one) within relative tolerance.
+	/// </summary>
+	bool TrySplitInto1DKernels(std::vector<float>& xDim, std::vector<float>& yDim, float tolerance = 1e-4f);
+
 	/// <summary> Prints kernel values into console </summary>
 	void Print();
 
@@ -0,0 +1,414 @@
+#include <iostream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "Histogram.hpp"
+#include "Monadic.hpp"
+#include "Simd.hpp"
+#include "Utils.hpp"
+
+namespace Monadic
+{
+	/// <summary> Number of pixels processed by one task of Apply </summary>
+	static const size_t BlockSize = 1 << 16;
+
+	/// <summary> Number of values of ApplyFused block (16 kB, fits into L1 cache) </summary>
+	static const size_t FusedBlockSize = 4096;
+
+	bool IsPointOperation(Image::MonadicOperationType type)
+	{
+		return type != Image::MonadicOperationType::HISTOGRAM_EQUALIZATION
+			&& type != Image::MonadicOperationType::ADAPTIVE_HISTOGRAM_EQUALIZATION;
+	}
+
+	/// <summary>
+	/// Applies single operation to value, equalization needs CDF of given number of levels (it is skipped without it).
+	/// </summary>
+	static inline float EvaluateOne(const Image::MonadicOperation& operation, float x, const float* cdf, int levels)
+	{
+		using Type = Image::MonadicOperationType;
+
+		switch (operation.type) {
+		case Type::NEGATIVE:
+			return Negative(x);
+		case Type::THRESHOLD:
+			return Threshold(x, operation.value);
+		case Type::BRIGHTNESS:
+			return Brightness(x, operation.value);
+		case Type::CONTRAST:
+			return Contrast(x, operation.value);
+		case Type::GAMMA_CORRECTION:
+			return GammaCorrection(x, operation.value);
+		case Type::QUANTIZATION:
+			return Quantization(x, static_cast<int>(operation.value));
+		case Type::HISTOGRAM_EQUALIZATION:
+			return cdf != nullptr ? std::clamp(cdf[std::clamp(static_cast<int>(x * (levels - 1)), 0, levels - 1)], 0.0f, 1.0f) : x;
+		default:
+			return x;
+		}
+	}
+
+	float Evaluate(const Image::MonadicOperation& operation, float x, const float* cdf, int levels)
+	{
+		return EvaluateOne(operation, x, cdf, levels);
+	}
+
+	float Evaluate(const std::vector<Image::MonadicOperation>& chain, float x)
+	{
+		for (const Image::MonadicOperation& operation : chain) {
+			x = EvaluateOne(operation, x, nullptr, 0);
+		}
+
+		return x;
+	}
+
+	/// <summary>
+	/// Whether operation leaves values in <0,1> unchanged.
+	/// </summary>
+	static bool IsIdentity(const Image::MonadicOperation& operation)
+	{
+		using Type = Image::MonadicOperationType;
+
+		return (operation.type == Type::BRIGHTNESS && operation.value == 0.0f)
+			|| (operation.type == Type::CONTRAST && operation.value == 1.0f)
+			|| (operation.type == Type::GAMMA_CORRECTION && operation.value == 1.0f);
+	}
+
+	/// <summary>
+	/// Tries to replace two consecutive operations by one (stored to first), returns false when they cannot merge.
+	/// </summary>
+	static bool Merge(Image::MonadicOperation& first, const Image::MonadicOperation& second)
+	{
+		using Type = Image::MonadicOperationType;
+
+		if (first.type != second.type) {
+			return false;
+		}
+
+		switch (first.type) {
+		case Type::BRIGHTNESS:
+			// Shifts of one direction clamp on the same side, so clamping after the first one changes nothing
+			if ((first.value >= 0.0f) != (second.value >= 0.0f)) {
+				return false;
+			}
+			first.value += second.value;
+			return true;
+		case Type::CONTRAST:
+			// Both stretch or both shrink non-negative values
+			if (first.value < 0.0f || second.value < 0.0f || (first.value >= 1.0f) != (second.value >= 1.0f)) {
+				return false;
+			}
+			first.value *= second.value;
+			return true;
+		case Type::GAMMA_CORRECTION:
+			// Positive powers keep values in <0,1>, (x^a)^b = x^(a * b)
+			if (first.value <= 0.0f || second.value <= 0.0f) {
+				return false;
+			}
+			first.value *= second.value;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	std::vector<Image::MonadicOperation> Simplify(const std::vector<Image::MonadicOperation>& chain)
+	{
+		std::vector<Image::MonadicOperation> simplified;
+
+		for (const Image::MonadicOperation& operation : chain) {
+			if (IsIdentity(operation)) {
+				continue;
+			}
+
+			if (!simplified.empty()) {
+				Image::MonadicOperation& last = simplified.back();
+
+				if (last.type == Image::MonadicOperationType::NEGATIVE && operation.type == Image::MonadicOperationType::NEGATIVE) {
+					simplified.pop_back();
+					continue;
+				}
+
+				if (Merge(last, operation)) {
+					// Merged operation may become identity, e.g. gammas 2 and 0.5
+					if (IsIdentity(last)) {
+						simplified.pop_back();
+					}
+					continue;
+				}
+			}
+
+			simplified.push_back(operation);
+		}
+
+		return simplified;
+	}
+
+	/// <summary>
+	/// Applies single operation to Simd::width values.
+	/// </summary>
+	static inline Simd::Float EvaluateVector(const Image::MonadicOperation& operation, Simd::Float x, const float* cdf, int levels)
+	{
+		using Type = Image::MonadicOperationType;
+		const Simd::Float zero = Simd::zero();
+		const Simd::Float one = Simd::broadcast(1.0f);
+		const Simd::Float value = Simd::broadcast(operation.value);
+
+		switch (operation.type) {
+		case Type::NEGATIVE:
+			return Simd::sub(one, x);
+		case Type::THRESHOLD:
+			// x < value ? 0 : 1
+			return Simd::lessEqual(value, x);
+		case Type::BRIGHTNESS:
+			return Simd::max(Simd::min(Simd::add(x, value), one), zero);
+		case Type::CONTRAST:
+			return Simd::max(Simd::min(Simd::mul(x, value), one), zero);
+		case Type::GAMMA_CORRECTION:
+			return Simd::max(Simd::min(Simd::pow(x, value), one), zero);
+		case Type::QUANTIZATION: {
+			const Simd::Float levels = Simd::broadcast(static_cast<float>(static_cast<int>(operation.value)));
+			return Simd::max(Simd::min(Simd::div(Simd::floor(Simd::mul(x, levels)), levels), one), zero);
+		}
+		case Type::HISTOGRAM_EQUALIZATION: {
+			if (cdf == nullptr) {
+				return x;
+			}
+
+			const Simd::Float last = Simd::broadcast(static_cast<float>(levels - 1));
+			Simd::Float level = Simd::max(Simd::min(Simd::mul(x, last), last), zero);
+			return Simd::max(Simd::min(Simd::lookup(cdf, level), one), zero);
+		}
+		default:
+			return x;
+		}
+	}
+
+	/// <summary>
+	/// Runs chain over data in cache sized blocks, operation i equalizes by cdfs[i] of levels[i] values.
+	/// </summary>
+	static void RunFused(
+		const std::vector<Image::MonadicOperation>& chain,
+		float* data,
+		size_t count,
+		const std::vector<const float*>& cdfs,
+		const std::vector<int>& levels
+	)
+	{
+		if (chain.empty()) {
+			return;
+		}
+
+		const int blocks = static_cast<int>((count + FusedBlockSize - 1) / FusedBlockSize);
+
+		Utils::ParallelBands(blocks, [&](int begin, int end) {
+			for (int block = begin; block < end; block++) {
+				float* values = data + block * FusedBlockSize;
+				const size_t length = std::min(FusedBlockSize, count - block * FusedBlockSize);
+
+				// Block stays in cache while all operations run over it
+				for (size_t o = 0; o < chain.size(); o++) {
+					const Image::MonadicOperation& operation = chain[o];
+
+					size_t i = 0;
+					for (; i + Simd::width <= length; i += Simd::width) {
+						Simd::store(values + i, EvaluateVector(operation, Simd::load(values + i), cdfs[o], levels[o]));
+					}
+					for (; i < length; i++) {
+						values[i] = EvaluateOne(operation, values[i], cdfs[o], levels[o]);
+					}
+				}
+			}
+		});
+	}
+
+	void ApplyFused(const std::vector<Image::MonadicOperation>& chain, float* data, size_t count, const float* cdf, int levels)
+	{
+		RunFused(chain, data, count, std::vector<const float*>(chain.size(), cdf), std::vector<int>(chain.size(), levels));
+	}
+
+	void ApplyFused(const std::vector<Image::MonadicOperation>& chain, float* data, size_t count, const std::vector<std::vector<float>>& cdfs)
+	{
+		std::vector<const float*> operationCdfs(chain.size(), nullptr);
+		std::vector<int> operationLevels(chain.size(), 0);
+
+		size_t next = 0;
+		for (size_t o = 0; o < chain.size() && next < cdfs.size(); o++) {
+			if (chain[o].type == Image::MonadicOperationType::HISTOGRAM_EQUALIZATION) {
+				operationCdfs[o] = cdfs[next].data();
+				operationLevels[o] = static_cast<int>(cdfs[next].size());
+				next++;
+			}
+		}
+
+		RunFused(chain, data, count, operationCdfs, operationLevels);
+	}
+
+	/// <summary>
+	/// Evaluates chain for every code of Pixel type, padding entries repeat the last code. With histogram
+	/// of codes, equalization uses CDF of codes as they are at its position in chain.
+	/// </summary>
+	template <typename Pixel>
+	static bool CompileTable(const std::vector<Image::MonadicOperation>& chain, std::vector<Pixel>& table, const std::vector<int>* codeHistogram)
+	{
+		for (const Image::MonadicOperation& operation : chain) {
+			const bool equalizable = codeHistogram != nullptr && operation.type == Image::MonadicOperationType::HISTOGRAM_EQUALIZATION;
+
+			if (!IsPointOperation(operation.type) && !equalizable) {
+				std::cout << "Only point operations can be compiled into lookup table" << std::endl;
+				return false;
+			}
+		}
+
+		constexpr int codes = 1 << (8 * sizeof(Pixel));
+		// Gathers read 32 bits starting at the looked up entry
+		constexpr int padding = 4 / sizeof(Pixel) - 1;
+		const float maximum = static_cast<float>(codes - 1);
+
+		std::vector<float> values(codes);
+		for (int code = 0; code < codes; code++) {
+			values[code] = code / maximum;
+		}
+
+		for (const Image::MonadicOperation& operation : chain) {
+			std::vector<float> cdf;
+
+			if (operation.type == Image::MonadicOperationType::HISTOGRAM_EQUALIZATION) {
+				// Pixels of every source code have the same value here, so histogram of values is exact
+				std::vector<int> histogram(codes, 0);
+				for (int code = 0; code < codes; code++) {
+					histogram[std::lround(std::clamp(values[code], 0.0f, 1.0f) * maximum)] += (*codeHistogram)[code];
+				}
+				cdf = Histogram::Cumulative(histogram);
+			}
+
+			for (float& value : values) {
+				value = EvaluateOne(operation, value, cdf.empty() ? nullptr : cdf.data(), codes);
+			}
+		}
+
+		table.resize(codes + padding);
+		for (int code = 0; code < codes; code++) {
+			table[code] = static_cast<Pixel>(std::lround(std::clamp(values[code], 0.0f, 1.0f) * maximum));
+		}
+		std::fill(table.begin() + codes, table.end(), table[codes - 1]);
+
+		return true;
+	}
+
+	bool Compile(const std::vector<Image::MonadicOperation>& chain, std::vector<uint8_t>& table)
+	{
+		return CompileTable(chain, table, nullptr);
+	}
+
+	bool Compile(const std::vector<Image::MonadicOperation>& chain, std::vector<uint16_t>& table)
+	{
+		return CompileTable(chain, table, nullptr);
+	}
+
+	bool Compile(const std::vector<Image::MonadicOperation>& chain, std::vector<uint8_t>& table, const std::vector<int>& codeHistogram)
+	{
+		return CompileTable(chain, table, &codeHistogram);
+	}
+
+	bool Compile(const std::vector<Image::MonadicOperation>& chain, std::vector<uint16_t>& table, const std::vector<int>& codeHistogram)
+	{
+		return CompileTable(chain, table, &codeHistogram);
+	}
+
+	/// <summary>
+	/// Looks up count 8-bit codes, returns number of codes processed by SIMD (the rest is left to caller).
+	/// </summary>
+	static size_t LookupBlock(const uint8_t* table, const uint8_t* source, uint8_t* destination, size_t count)
+	{
+		size_t i = 0;
+#if defined(__AVX512VBMI__)
+		// Whole table fits into four registers, two-source byte permutes look up its halves
+		// and the highest bit of code selects between them
+		const __m512i table0 = _mm512_loadu_si512(table);
+		const __m512i table1 = _mm512_loadu_si512(table + 64);
+		const __m512i table2 = _mm512_loadu_si512(table + 128);
+		const __m512i table3 = _mm512_loadu_si512(table + 192);
+
+		for (; i + 64 <= count; i += 64) {
+			__m512i codes = _mm512_loadu_si512(source + i);
+			__m512i lower = _mm512_permutex2var_epi8(table0, codes, table1);
+			__m512i upper = _mm512_permutex2var_epi8(table2, codes, table3);
+			_mm512_storeu_si512(destination + i, _mm512_mask_blend_epi8(_mm512_movepi8_mask(codes), lower, upper));
+		}
+#elif defined(__AVX2__)
+		// Gathers 32 bits at every code, lowest byte is the entry, packing keeps order after final permute
+		const __m256i mask = _mm256_set1_epi32(0xFF);
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		const int* base = reinterpret_cast<const int*>(table);
+
+		for (; i + 32 <= count; i += 32) {
+			__m256i values[4];
+			for (int k = 0; k < 4; k++) {
+				__m256i codes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i + 8 * k)));
+				values[k] = _mm256_and_si256(_mm256_i32gather_epi32(base, codes, 1), mask);
+			}
+
+			__m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(values[0], values[1]), _mm256_packus_epi32(values[2], values[3]));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_permutevar8x32_epi32(packed, order));
+		}
+#endif
+		return i;
+	}
+
+	/// <summary>
+	/// Looks up count 16-bit codes, returns number of codes processed by SIMD (the rest is left to caller).
+	/// </summary>
+	static size_t LookupBlock(const uint16_t* table, const uint16_t* source, uint16_t* destination, size_t count)
+	{
+		size_t i = 0;
+		// Two 8-lane gathers were measured faster than one 16-lane gather of AVX-512
+#if defined(__AVX2__)
+		const __m256i mask = _mm256_set1_epi32(0xFFFF);
+		const int* base = reinterpret_cast<const int*>(table);
+
+		for (; i + 16 <= count; i += 16) {
+			__m256i codes0 = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+			__m256i codes1 = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 8)));
+			__m256i values0 = _mm256_and_si256(_mm256_i32gather_epi32(base, codes0, 2), mask);
+			__m256i values1 = _mm256_and_si256(_mm256_i32gather_epi32(base, codes1, 2), mask);
+
+			// Packing interleaves 128-bit lanes, permute restores their order
+			__m256i packed = _mm256_packus_epi32(values0, values1);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_permute4x64_epi64(packed, 0xD8));
+		}
+#endif
+		return i;
+	}
+
+	/// <summary>
+	/// Runs lookup of blocks in parallel, elements not handled by SIMD are looked up one by one.
+	/// </summary>
+	template <typename Pixel>
+	static void ApplyTable(const std::vector<Pixel>& table, const Pixel* source, Pixel* destination, size_t count)
+	{
+		const int blocks = static_cast<int>((count + BlockSize - 1) / BlockSize);
+
+		Utils::ParallelBands(blocks, [&](int begin, int end) {
+			const size_t first = begin * BlockSize;
+			const size_t last = std::min(count, end * BlockSize);
+
+			size_t i = first + LookupBlock(table.data(), source + first, destination + first, last - first);
+			for (; i < last; i++) {
+				destination[i] = table[source[i]];
+			}
+		});
+	}
+
+	void Apply(const std::vector<uint8_t>& table, const uint8_t* source, uint8_t* destination, size_t count)
+	{
+		ApplyTable(table, source, destination, count);
+	}
+
+	void Apply(const std::vector<uint16_t>& table, const uint16_t* source, uint16_t* destination, size_t count)
+	{
+		ApplyTable(table, source, destination, count);
+	}
+}
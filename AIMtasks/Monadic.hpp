@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Image.hpp"
+
+/// <summary>
+/// Namespace with monadic (point) operations of Task I and their compilation into lookup tables.
+///
+/// Every operation except histogram equalization maps pixel value to new value independently of other
+/// pixels, so chain of them is a function of single value. For integer pixels it is evaluated once for
+/// every possible code and then applied to image as table lookup, cost does not depend on operations.
+/// </summary>
+namespace Monadic
+{
+	inline float Negative(float x) { return 1 - x; }
+	inline float Threshold(float x, float value) { return x < value ? 0.0f : 1.0f; }
+	inline float Brightness(float x, float value) { return std::clamp(x + value, 0.0f, 1.0f); }
+	inline float Contrast(float x, float value) { return std::clamp(x * value, 0.0f, 1.0f); }
+	inline float GammaCorrection(float x, float value) { return std::clamp(std::pow(x, value), 0.0f, 1.0f); }
+	inline float Quantization(float x, int levels) { return std::clamp((std::floor(x * levels) / levels), 0.0f, 1.0f); }
+
+	/// <summary>
+	/// Whether operation depends on pixel value only (everything except histogram equalizations).
+	/// </summary>
+	bool IsPointOperation(Image::MonadicOperationType type);
+
+	/// <summary>
+	/// Applies chain of point operations to single value in <0,1>.
+	/// </summary>
+	float Evaluate(const std::vector<Image::MonadicOperation>& chain, float x);
+
+	/// <summary>
+	/// Applies single operation to value in <0,1>, histogram equalization maps it through given CDF
+	/// exactly as ApplyFused does (it is skipped when CDF is null).
+	/// </summary>
+	float Evaluate(const Image::MonadicOperation& operation, float x, const float* cdf, int levels);
+
+	/// <summary>
+	/// Removes redundant operations of chain applied to values in <0,1>, result is the same up to rounding.
+	///
+	/// Pairs of negatives cancel, neighbouring brightness shifts of the same sign, contrasts on the same
+	/// side of 1 and positive gammas merge into one operation (there is no clamping between them which
+	/// would make merging wrong) and operations which do nothing (brightness 0, contrast 1, gamma 1) are dropped.
+	/// </summary>
+	std::vector<Image::MonadicOperation> Simplify(const std::vector<Image::MonadicOperation>& chain);
+
+	/// <summary>
+	/// Applies chain of operations to float data in one pass over memory.
+	///
+	/// Data are processed in blocks small enough to stay in cache, every operation runs over block
+	/// vectorized (gamma correction by Simd::pow, relative difference to std::pow about 1e-6)
+	/// and blocks run in parallel. Histogram equalization maps values through given CDF.
+	/// </summary>
+	/// <param name="chain">Operations applied in order</param>
+	/// <param name="data">Values in <0,1> modified in place</param>
+	/// <param name="count">Number of values</param>
+	/// <param name="cdf">CDF for histogram equalization, equalization is skipped when null</param>
+	/// <param name="levels">Number of values of CDF, value v is equalized by CDF[(int)(v * (levels - 1))]</param>
+	void ApplyFused(const std::vector<Image::MonadicOperation>& chain, float* data, size_t count, const float* cdf = nullptr, int levels = 256);
+
+	/// <summary>
+	/// Variant of ApplyFused where n-th histogram equalization of chain maps values through n-th of given CDFs
+	/// (of any number of levels each), so that every equalization may use CDF of data as they are at its position.
+	/// </summary>
+	void ApplyFused(const std::vector<Image::MonadicOperation>& chain, float* data, size_t count, const std::vector<std::vector<float>>& cdfs);
+
+	/// <summary>
+	/// Compiles chain of point operations into table for 8-bit codes (code c stands for value c / 255).
+	///
+	/// Table has 256 entries followed by padding (copies of the last entry) read by SIMD gathers,
+	/// it is meant to be used by Apply only.
+	/// </summary>
+	/// <param name="chain">Operations applied in order</param>
+	/// <param name="table">Vector where to save table</param>
+	/// <returns>False when chain contains operation which is not point operation.</returns>
+	bool Compile(const std::vector<Image::MonadicOperation>& chain, std::vector<uint8_t>& table);
+
+	/// <summary>
+	/// Compiles chain of point operations into table for 16-bit codes (code c stands for value c / 65535).
+	/// </summary>
+	bool Compile(const std::vector<Image::MonadicOperation>& chain, std::vector<uint16_t>& table);
+
+	/// <summary>
+	/// Compiles chain including histogram equalizations for image with given histogram of codes (one bin per code,
+	/// see Histogram::Compute). All pixels of one code stay equal through chain, so CDF of their values at position
+	/// of every equalization is exact and whole chain still maps codes to codes.
+	/// </summary>
+	bool Compile(const std::vector<Image::MonadicOperation>& chain, std::vector<uint8_t>& table, const std::vector<int>& codeHistogram);
+	bool Compile(const std::vector<Image::MonadicOperation>& chain, std::vector<uint16_t>& table, const std::vector<int>& codeHistogram);
+
+	/// <summary>
+	/// Maps every code of source through compiled table, runs in parallel with SIMD gathers where available.
+	/// </summary>
+	/// <param name="table">Table created by Compile</param>
+	/// <param name="source">Input codes</param>
+	/// <param name="destination">Output codes (may alias source)</param>
+	/// <param name="count">Number of pixels</param>
+	void Apply(const std::vector<uint8_t>& table, const uint8_t* source, uint8_t* destination, size_t count);
+
+	/// <summary>
+	/// Maps every 16-bit code of source through compiled table.
+	/// </summary>
+	void Apply(const std::vector<uint16_t>& table, const uint16_t* source, uint16_t* destination, size_t count);
+}
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <bit>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+#include "Pixel.hpp"
+#include "Utils.hpp"
+
+namespace Pixel
+{
+	/// <summary> Number of pixels converted by one task </summary>
+	static const size_t BlockSize = 1 << 16;
+
+	float HalfToFloat(Half value)
+	{
+		const uint32_t sign = static_cast<uint32_t>(value.bits & 0x8000) << 16;
+		const uint32_t exponent = (value.bits >> 10) & 0x1F;
+		const uint32_t mantissa = value.bits & 0x3FF;
+
+		if (exponent == 0) {
+			// Zero or subnormal, mantissa * 2^-24
+			const float magnitude = mantissa * 5.9604645e-8f;
+			return sign != 0 ? -magnitude : magnitude;
+		}
+		if (exponent == 31) {
+			return std::bit_cast<float>(sign | 0x7F800000u | (mantissa << 13));
+		}
+
+		return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+	}
+
+	Half FloatToHalf(float value)
+	{
+		// Giesen: float_to_half_fast3_rtne
+		uint32_t bits = std::bit_cast<uint32_t>(value);
+		const uint32_t sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		uint16_t result;
+		if (bits >= (127u + 16u) << 23) {
+			// Beyond range of half, NaN stays quiet NaN
+			result = bits > 0x7F800000u ? 0x7E00 : 0x7C00;
+		} else if (bits < 113u << 23) {
+			// Subnormal half, adding magic value aligns its mantissa and rounds it to nearest even
+			const uint32_t magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+			const float aligned = std::bit_cast<float>(bits) + std::bit_cast<float>(magic);
+			result = static_cast<uint16_t>(std::bit_cast<uint32_t>(aligned) - magic);
+		} else {
+			// Rebias exponent and round to nearest even, carry into exponent gives infinity on overflow
+			const uint32_t odd = (bits >> 13) & 1;
+			bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFF + odd;
+			result = static_cast<uint16_t>(bits >> 13);
+		}
+
+		return { static_cast<uint16_t>(result | (sign >> 16)) };
+	}
+
+	/// <summary>
+	/// Runs conversion of blocks of pixels in parallel.
+	/// </summary>
+	template <typename Function>
+	static void ConvertBlocks(size_t count, Function convert)
+	{
+		const int blocks = static_cast<int>((count + BlockSize - 1) / BlockSize);
+
+		Utils::ParallelBands(blocks, [&](int begin, int end) {
+			const size_t first = begin * BlockSize;
+			convert(first, std::min(count, end * BlockSize));
+		});
+	}
+
+	/// <summary>
+	/// Converts integer codes, loops are simple enough to be vectorized by compiler.
+	/// </summary>
+	template <typename Code>
+	static void CodesToFloat(const Code* source, float* destination, size_t count)
+	{
+		const float maximum = static_cast<float>(Traits<Code>::maximum);
+
+		ConvertBlocks(count, [=](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				destination[i] = source[i] / maximum;
+			}
+		});
+	}
+
+	template <typename Code>
+	static void FloatToCodes(const float* source, Code* destination, size_t count)
+	{
+		ConvertBlocks(count, [=](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				destination[i] = FromValue<Code>(source[i]);
+			}
+		});
+	}
+
+	void ToFloat(const uint8_t* source, float* destination, size_t count)
+	{
+		CodesToFloat(source, destination, count);
+	}
+
+	void ToFloat(const uint16_t* source, float* destination, size_t count)
+	{
+		CodesToFloat(source, destination, count);
+	}
+
+	void ToFloat(const float* source, float* destination, size_t count)
+	{
+		ConvertBlocks(count, [=](size_t first, size_t last) {
+			std::copy(source + first, source + last, destination + first);
+		});
+	}
+
+	void ToFloat(const Half* source, float* destination, size_t count)
+	{
+		ConvertBlocks(count, [=](size_t first, size_t last) {
+			size_t i = first;
+#if defined(__F16C__)
+			for (; i + 8 <= last; i += 8) {
+				__m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+				_mm256_storeu_ps(destination + i, _mm256_cvtph_ps(halves));
+			}
+#endif
+			for (; i < last; i++) {
+				destination[i] = HalfToFloat(source[i]);
+			}
+		});
+	}
+
+	void FromFloat(const float* source, uint8_t* destination, size_t count)
+	{
+		FloatToCodes(source, destination, count);
+	}
+
+	void FromFloat(const float* source, uint16_t* destination, size_t count)
+	{
+		FloatToCodes(source, destination, count);
+	}
+
+	void FromFloat(const float* source, float* destination, size_t count)
+	{
+		ToFloat(source, destination, count);
+	}
+
+	void FromFloat(const float* source, Half* destination, size_t count)
+	{
+		ConvertBlocks(count, [=](size_t first, size_t last) {
+			size_t i = first;
+#if defined(__F16C__)
+			for (; i + 8 <= last; i += 8) {
+				__m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), halves);
+			}
+#endif
+			for (; i < last; i++) {
+				destination[i] = FloatToHalf(source[i]);
+			}
+		});
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/// <summary>
+/// Namespace with compact pixel types and their conversion to and from float values in <0,1>.
+///
+/// Integer pixels are codes of fixed point values (code c of 8-bit pixel stands for c / 255), half
+/// stores float value with 11 significant bits in 2 B. Conversions run over bands in parallel.
+/// </summary>
+namespace Pixel
+{
+	/// <summary>
+	/// IEEE 754 half precision value, used for storage only (arithmetic is done in float).
+	/// </summary>
+	struct Half {
+		uint16_t bits = 0;
+	};
+
+	/// <summary>
+	/// Properties of pixel type.
+	/// </summary>
+	template <typename T>
+	struct Traits;
+
+	template <>
+	struct Traits<uint8_t> {
+		static constexpr bool integer = true;
+		/// <summary> Code of value 1 </summary>
+		static constexpr int maximum = 255;
+	};
+
+	template <>
+	struct Traits<uint16_t> {
+		static constexpr bool integer = true;
+		static constexpr int maximum = 65535;
+	};
+
+	template <>
+	struct Traits<float> {
+		static constexpr bool integer = false;
+		static constexpr int maximum = 1;
+	};
+
+	template <>
+	struct Traits<Half> {
+		static constexpr bool integer = false;
+		static constexpr int maximum = 1;
+	};
+
+	/// <summary>
+	/// Converts half to float (exact).
+	/// </summary>
+	float HalfToFloat(Half value);
+
+	/// <summary>
+	/// Converts float to nearest half (ties to even), values beyond range of half become infinities.
+	/// </summary>
+	Half FloatToHalf(float value);
+
+	/// <summary>
+	/// Converts value in <0,1> to single pixel (the same rounding as FromFloat).
+	/// </summary>
+	template <typename T>
+	inline T FromValue(float value)
+	{
+		if constexpr (std::is_same_v<T, Half>) {
+			return FloatToHalf(value);
+		} else if constexpr (Traits<T>::integer) {
+			// Clamped values are non-negative, so adding 0.5 and truncating rounds to nearest
+			return static_cast<T>(std::clamp(value, 0.0f, 1.0f) * Traits<T>::maximum + 0.5f);
+		} else {
+			return value;
+		}
+	}
+
+	/// <summary>
+	/// Converts pixels to float values in <0,1>.
+	/// </summary>
+	void ToFloat(const uint8_t* source, float* destination, size_t count);
+	void ToFloat(const uint16_t* source, float* destination, size_t count);
+	void ToFloat(const float* source, float* destination, size_t count);
+	void ToFloat(const Half* source, float* destination, size_t count);
+
+	/// <summary>
+	/// Converts float values to pixels, integer codes are rounded to nearest and values clamped to <0,1>.
+	/// </summary>
+	void FromFloat(const float* source, uint8_t* destination, size_t count);
+	void FromFloat(const float* source, uint16_t* destination, size_t count);
+	void FromFloat(const float* source, float* destination, size_t count);
+	void FromFloat(const float* source, Half* destination, size_t count);
+}
@@ -0,0 +1,310 @@
+#include <iostream>
+#include <algorithm>
+
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+#include "PixelImage.hpp"
+#include "Clahe.hpp"
+#include "Convolution.hpp"
+#include "Histogram.hpp"
+#include "Monadic.hpp"
+#include "Utils.hpp"
+
+/// <summary>
+/// Number of pixels converted to float at once by operations working on chunks or strips (4 MB of floats).
+/// </summary>
+static const size_t ChunkSize = 1 << 20;
+
+/// <summary>
+/// Calls function(values, count) with float copies of consecutive chunks of pixels, values modified
+/// by function are stored back when writeBack is set. Float pixels are passed directly.
+/// </summary>
+template <typename PixelType, typename Function>
+static void ForEachChunk(PixelType* data, size_t count, Function function, bool writeBack) {
+    if constexpr (std::is_same_v<PixelType, float>) {
+        function(data, count);
+    } else {
+        std::vector<float> values(std::min(count, ChunkSize));
+
+        for (size_t first = 0; first < count; first += ChunkSize) {
+            const size_t length = std::min(ChunkSize, count - first);
+
+            Pixel::ToFloat(data + first, values.data(), length);
+            function(values.data(), length);
+            if (writeBack) {
+                Pixel::FromFloat(values.data(), data + first, length);
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Converts loaded pixels of given number of components to luminance pixels.
+/// </summary>
+template <typename PixelType, typename Source>
+static void LoadLuminance(const Source* pixels, int components, float maximum, int width, int height, PixelType* destination) {
+    Utils::ParallelBands(height, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const Source* row = pixels + (size_t)y * width * components;
+            PixelType* destinationRow = destination + (size_t)y * width;
+
+            for (int x = 0; x < width; x++) {
+                const Source* pixel = row + (size_t)x * components;
+                float value = components >= 3 ? Utils::luminanceFromRGB(pixel[0], pixel[1], pixel[2]) : pixel[0];
+
+                destinationRow[x] = Pixel::FromValue<PixelType>(value / maximum);
+            }
+        }
+    });
+}
+
+template <typename PixelType>
+PixelImage<PixelType>::PixelImage(int width, int height) {
+    this->width = width;
+    this->height = height;
+
+    data.assign((size_t)width * height, Pixel::FromValue<PixelType>(0.0f));
+}
+
+template <typename PixelType>
+PixelImage<PixelType>::PixelImage(Image& image) {
+    image.evaluate();
+
+    width = image.width;
+    height = image.height;
+
+    const size_t size = image.planeSize();
+    data.resize(size);
+
+    if (image.channels < 3) {
+        Pixel::FromFloat(image.plane(0), data.data(), size);
+        return;
+    }
+
+    const float* red = image.plane(0);
+    const float* green = image.plane(1);
+    const float* blue = image.plane(2);
+
+    Utils::ParallelBands(height, [&](int begin, int end) {
+        std::vector<float> luminance(width);
+
+        for (int y = begin; y < end; y++) {
+            const size_t row = (size_t)y * width;
+            for (int x = 0; x < width; x++) {
+                luminance[x] = Utils::luminanceFromRGB(red[row + x], green[row + x], blue[row + x]);
+            }
+
+            Pixel::FromFloat(luminance.data(), data.data() + row, width);
+        }
+    });
+}
+
+template <typename PixelType>
+bool PixelImage<PixelType>::load(std::string path) {
+    int components;
+    if (stbi_info(path.c_str(), &width, &height, &components) != 1) {
+        std::cout << "Cannot load " << path << std::endl;
+        return false;
+    }
+
+    data.resize((size_t)width * height);
+
+    // Codes of 8-bit pixels cannot hold more precision, so 16-bit files are read as 16-bit only for other types
+    if (Pixel::Traits<PixelType>::maximum != 255 && stbi_is_16_bit(path.c_str())) {
+        stbi_us* pixels = stbi_load_16(path.c_str(), &width, &height, &components, 0);
+        if (pixels == nullptr) {
+            return false;
+        }
+
+        LoadLuminance(pixels, components, 65535.0f, width, height, data.data());
+        stbi_image_free(pixels);
+    } else {
+        stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &components, 0);
+        if (pixels == nullptr) {
+            return false;
+        }
+
+        LoadLuminance(pixels, components, 255.0f, width, height, data.data());
+        stbi_image_free(pixels);
+    }
+
+    return true;
+}
+
+template <typename PixelType>
+bool PixelImage<PixelType>::save(std::string path, int quality) {
+    std::vector<uint8_t> codes(data.size());
+
+    if constexpr (std::is_same_v<PixelType, uint8_t>) {
+        codes = data;
+    } else {
+        size_t offset = 0;
+        ForEachChunk(data.data(), data.size(), [&](float* values, size_t count) {
+            Pixel::FromFloat(values, codes.data() + offset, count);
+            offset += count;
+        }, false);
+    }
+
+    return stbi_write_jpg(path.c_str(), width, height, 1, static_cast<void*>(codes.data()), quality) != 0;
+}
+
+template <typename PixelType>
+void PixelImage<PixelType>::toFloat(std::vector<float>& destination) const {
+    destination.resize(data.size());
+    Pixel::ToFloat(data.data(), destination.data(), data.size());
+}
+
+template <typename PixelType>
+bool PixelImage<PixelType>::applyOperations(const std::vector<Image::MonadicOperation>& chain) {
+    // Adaptive equalization depends on neighbourhood of pixel, so parts of chain between them run separately
+    auto begin = chain.begin();
+    while (begin != chain.end()) {
+        auto end = std::find_if(begin, chain.end(), [](const Image::MonadicOperation& operation) {
+            return operation.type == Image::MonadicOperationType::ADAPTIVE_HISTOGRAM_EQUALIZATION;
+        });
+
+        if (!applyPointOperations(std::vector<Image::MonadicOperation>(begin, end))) {
+            return false;
+        }
+
+        if (end != chain.end()) {
+            std::vector<float> values;
+            toFloat(values);
+            Clahe::Apply(values.data(), values.data(), width, height, adaptiveTilesX, adaptiveTilesY, end->value);
+            Pixel::FromFloat(values.data(), data.data(), data.size());
+            end++;
+        }
+
+        begin = end;
+    }
+
+    return true;
+}
+
+template <typename PixelType>
+bool PixelImage<PixelType>::applyPointOperations(const std::vector<Image::MonadicOperation>& chain) {
+    if (chain.empty()) {
+        return true;
+    }
+
+    if constexpr (Pixel::Traits<PixelType>::integer) {
+        constexpr int codes = Pixel::Traits<PixelType>::maximum + 1;
+
+        const bool equalizes = std::any_of(chain.begin(), chain.end(), [](const Image::MonadicOperation& operation) {
+            return operation.type == Image::MonadicOperationType::HISTOGRAM_EQUALIZATION;
+        });
+
+        // Codes are counted only when equalization needs their CDF
+        std::vector<PixelType> table;
+        bool compiled = equalizes
+            ? Monadic::Compile(chain, table, Histogram::Compute(data.data(), data.size(), codes))
+            : Monadic::Compile(chain, table);
+        if (!compiled) {
+            return false;
+        }
+
+        Monadic::Apply(table, data.data(), data.data(), data.size());
+    } else {
+        // Equalization needs CDF of data as they are at its position, so chain runs fused in parts
+        // starting at equalizations and CDF is counted before each part
+        std::vector<std::vector<float>> cdfs;
+        size_t begin = 0;
+
+        auto runPart = [&](size_t end) {
+            std::vector<Image::MonadicOperation> part(chain.begin() + begin, chain.begin() + end);
+
+            ForEachChunk(data.data(), data.size(), [&](float* values, size_t count) {
+                Monadic::ApplyFused(part, values, count, cdfs);
+            }, true);
+        };
+
+        for (size_t o = 0; o < chain.size(); o++) {
+            if (chain[o].type != Image::MonadicOperationType::HISTOGRAM_EQUALIZATION) {
+                continue;
+            }
+
+            if (o > begin) {
+                runPart(o);
+                begin = o;
+            }
+            cdfs = { Histogram::Cumulative(computeHistogram()) };
+        }
+        runPart(chain.size());
+    }
+
+    return true;
+}
+
+template <typename PixelType>
+std::vector<int> PixelImage<PixelType>::computeHistogram(int bins) const {
+    if constexpr (Pixel::Traits<PixelType>::integer || std::is_same_v<PixelType, float>) {
+        return Histogram::Compute(data.data(), data.size(), bins);
+    } else {
+        std::vector<int> histogram(std::max(bins, 1), 0);
+
+        // Chunks are only read, so pixels are not modified
+        ForEachChunk(const_cast<PixelType*>(data.data()), data.size(), [&](float* values, size_t count) {
+            std::vector<int> partial = Histogram::Compute(values, count, bins);
+            for (size_t b = 0; b < histogram.size(); b++) {
+                histogram[b] += partial[b];
+            }
+        }, false);
+
+        return histogram;
+    }
+}
+
+template <typename PixelType>
+void PixelImage<PixelType>::Convolute(Kernel& kernel, PixelImage<PixelType>& destination) const {
+    destination.width = width;
+    destination.height = height;
+    destination.data.resize(data.size());
+
+    std::vector<float> xTaps;
+    std::vector<float> yTaps;
+    const bool separable = kernel.TrySplitInto1DKernels(xTaps, yTaps);
+    const int radius = kernel.size / 2;
+
+    // Apron rows are clamped by convolution only at strip border, which never reaches rows of strip itself
+    const int stripRows = std::max(8 * kernel.size, (int)(ChunkSize / std::max(width, 1)));
+
+    std::vector<float> input;
+    std::vector<float> output;
+
+    for (int first = 0; first < height; first += stripRows) {
+        const int last = std::min(height, first + stripRows);
+        const int apronFirst = std::max(0, first - radius);
+        const int apronLast = std::min(height, last + radius);
+        const int rows = apronLast - apronFirst;
+
+        input.resize((size_t)rows * width);
+        Pixel::ToFloat(data.data() + (size_t)apronFirst * width, input.data(), input.size());
+
+        output.resize(input.size());
+
+        // Cost model of Image::Convolute, small kernels are cheaper tap by tap than through FFT
+        switch (Convolution::ChooseAlgorithm(kernel.size, separable, width, rows)) {
+        case Convolution::Algorithm::Direct:
+            Convolution::Direct(input.data(), output.data(), width, rows, kernel.values, kernel.size);
+            break;
+        case Convolution::Algorithm::Separable:
+            Convolution::Separable(input.data(), output.data(), width, rows, xTaps, yTaps);
+            break;
+        case Convolution::Algorithm::FFT:
+            Convolution::FFT(input.data(), output.data(), width, rows, kernel.values, kernel.size);
+            break;
+        }
+
+        Pixel::FromFloat(
+            output.data() + (size_t)(first - apronFirst) * width,
+            destination.data.data() + (size_t)first * width,
+            (size_t)(last - first) * width
+        );
+    }
+}
+
+template class PixelImage<uint8_t>;
+template class PixelImage<uint16_t>;
+template class PixelImage<float>;
+template class PixelImage<Pixel::Half>;
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Image.hpp"
+#include "Kernel.hpp"
+#include "Pixel.hpp"
+
+/// <summary>
+/// Grayscale image with pixels stored in compact type: uint8_t, uint16_t, float or Pixel::Half.
+///
+/// Image stores every pixel as float (4 B), while 8-bit sources need only one, PixelImage keeps them
+/// at source precision, so batches of images take quarter of memory and passes move quarter of bytes.
+/// Operations have kernels specialized for pixel type: point operations of integer pixels are compiled into
+/// lookup tables of codes (histogram equalization included), histograms count codes directly and float is
+/// used only where precision needs it (convolution, operations of half pixels), on strips or chunks
+/// small enough to stay in cache instead of float copy of whole image.
+/// Instantiated for uint8_t, uint16_t, float and Pixel::Half.
+/// </summary>
+template <typename PixelType>
+class PixelImage {
+public:
+    /// <summary> Width of image </summary>
+    int width = 0;
+    /// <summary> Height of image </summary>
+    int height = 0;
+
+    /// <summary> Pixels in rows, integer codes stand for values in <0,1> (see Pixel::Traits) </summary>
+    std::vector<PixelType> data;
+
+    /// <summary> Number of tile columns of adaptive histogram equalization </summary>
+    int adaptiveTilesX = 8;
+    /// <summary> Number of tile rows of adaptive histogram equalization </summary>
+    int adaptiveTilesY = 8;
+
+    PixelImage() = default;
+
+    /// <summary>
+    /// Creates black image of given size.
+    /// </summary>
+    PixelImage(int width, int height);
+
+    /// <summary>
+    /// Converts data of image (recorded operations of image are applied first). Like Image::load, colour
+    /// images are converted to luminance and other multi-channel images keep their first plane.
+    /// </summary>
+    explicit PixelImage(Image& image);
+
+    /// <summary>
+    /// Loads image from file as luminance, 16-bit files keep their precision unless pixels are 8-bit.
+    /// </summary>
+    /// <param name="path">Path to image file.</param>
+    /// <returns>True on success.</returns>
+    bool load(std::string path);
+
+    /// <summary>
+    /// Saves image as 8-bit grayscale JPEG.
+    /// </summary>
+    /// <param name="path">Path to output file.</param>
+    /// <param name="quality">Quality of JPEG</param>
+    /// <returns>True on success.</returns>
+    bool save(std::string path, int quality = 90);
+
+    /// <summary>
+    /// Converts pixels to float values in <0,1>.
+    /// </summary>
+    /// <param name="destination">Vector where to save values</param>
+    void toFloat(std::vector<float>& destination) const;
+
+    /// <summary>
+    /// Applies chain of monadic operations to pixels.
+    ///
+    /// Integer pixels are mapped through table of codes compiled from chain (Monadic::Compile), equalization uses
+    /// exact CDF of codes at its position. Float and half pixels run chain fused (Monadic::ApplyFused), equalization
+    /// uses CDF of 256 bins counted just before it. Adaptive equalization is computed on float copy of image.
+    /// </summary>
+    /// <param name="chain">Operations applied in order</param>
+    /// <returns>False when chain cannot be compiled.</returns>
+    bool applyOperations(const std::vector<Image::MonadicOperation>& chain);
+
+    /// <summary>
+    /// Histogram of pixel values (bins as in Histogram::Compute), integer codes are counted without conversion.
+    /// </summary>
+    /// <param name="bins">Number of bins</param>
+    /// <returns>Counts of all bins</returns>
+    std::vector<int> computeHistogram(int bins = 256) const;
+
+    /// <summary>
+    /// Convolutes image with kernel, result is stored in the same pixel type (integer codes are clamped to <0,1>).
+    ///
+    /// Strips of rows together with apron of kernel radius are converted to float and convoluted directly,
+    /// separably (rank one kernels) or by FFT, whichever Convolution::ChooseAlgorithm estimates cheapest,
+    /// strips are processed one by one, each in parallel.
+    /// </summary>
+    /// <param name="kernel">Kernel to convolute with.</param>
+    /// <param name="destination">Image where to save convoluted image.</param>
+    void Convolute(Kernel& kernel, PixelImage<PixelType>& destination) const;
+
+private:
+    /// <summary>
+    /// Applies chain without adaptive equalization.
+    /// </summary>
+    bool applyPointOperations(const std::vector<Image::MonadicOperation>& chain);
+};
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+/// <summary>
+/// Namespace wrapping SIMD instructions of the widest instruction set enabled at compile time
+/// (AVX-512, AVX2, SSE) with scalar fallback, so kernels can be written once.
+/// </summary>
+namespace Simd
+{
+#if defined(__AVX512F__)
+	/// <summary> Name of used instruction set </summary>
+	constexpr const char* name = "AVX-512";
+	/// <summary> Number of floats processed by one instruction </summary>
+	constexpr int width = 16;
+	/// <summary> Vector of floats </summary>
+	using Float = __m512;
+
+	inline Float load(const float* p) { return _mm512_loadu_ps(p); }
+	inline void store(float* p, Float v) { _mm512_storeu_ps(p, v); }
+	inline Float broadcast(float v) { return _mm512_set1_ps(v); }
+	inline Float zero() { return _mm512_setzero_ps(); }
+	inline Float add(Float a, Float b) { return _mm512_add_ps(a, b); }
+	inline Float mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+	inline Float mulAdd(Float a, Float b, Float c) { return _mm512_fmadd_ps(a, b, c); }
+	inline Float sub(Float a, Float b) { return _mm512_sub_ps(a, b); }
+	inline Float max(Float a, Float b) { return _mm512_max_ps(a, b); }
+	inline Float sqrt(Float v) { return _mm512_sqrt_ps(v); }
+	inline Float min(Float a, Float b) { return _mm512_min_ps(a, b); }
+	inline Float div(Float a, Float b) { return _mm512_div_ps(a, b); }
+	inline Float abs(Float v) { return _mm512_abs_ps(v); }
+	/// <summary> Gathers table[index] for each lane, index must hold non-negative integers within table </summary>
+	inline Float lookup(const float* table, Float index) { return _mm512_i32gather_ps(_mm512_cvttps_epi32(index), table, 4); }
+	/// <summary> 1 where a is less or equal to b, 0 elsewhere </summary>
+	inline Float lessEqual(Float a, Float b) { return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(a, b, _CMP_LE_OQ), _mm512_set1_ps(1.0f)); }
+	/// <summary> Rounds to nearest integer </summary>
+	inline Float round(Float v) { return _mm512_roundscale_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	/// <summary> Rounds down to integer </summary>
+	inline Float floor(Float v) { return _mm512_roundscale_ps(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+	/// <summary> Multiplies by 2 to the power of integral exponent (within range of normal numbers) </summary>
+	inline Float ldexp(Float v, Float exponent) { return _mm512_scalef_ps(v, exponent); }
+
+	/// <summary>
+	/// Splits positive normal numbers to mantissa in <sqrt(0.5), sqrt(2)) and exponent (as float).
+	/// </summary>
+	inline void split(Float v, Float& mantissa, Float& exponent)
+	{
+		__m512i bits = _mm512_castps_si512(v);
+		Float e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(127)));
+		Float m = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f800000)));
+
+		__mmask16 large = _mm512_cmp_ps_mask(m, _mm512_set1_ps(1.41421356f), _CMP_GT_OQ);
+		mantissa = _mm512_mask_mul_ps(m, large, m, _mm512_set1_ps(0.5f));
+		exponent = _mm512_mask_add_ps(e, large, e, _mm512_set1_ps(1.0f));
+	}
+#elif defined(__AVX2__)
+	constexpr const char* name = "AVX2";
+	constexpr int width = 8;
+	using Float = __m256;
+
+	inline Float load(const float* p) { return _mm256_loadu_ps(p); }
+	inline void store(float* p, Float v) { _mm256_storeu_ps(p, v); }
+	inline Float broadcast(float v) { return _mm256_set1_ps(v); }
+	inline Float zero() { return _mm256_setzero_ps(); }
+	inline Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+	inline Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+#if defined(__FMA__)
+	inline Float mulAdd(Float a, Float b, Float c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+	inline Float mulAdd(Float a, Float b, Float c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+	inline Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+	inline Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+	inline Float sqrt(Float v) { return _mm256_sqrt_ps(v); }
+	inline Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+	inline Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+	inline Float abs(Float v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+	inline Float lookup(const float* table, Float index) { return _mm256_i32gather_ps(table, _mm256_cvttps_epi32(index), 4); }
+	inline Float lessEqual(Float a, Float b) { return _mm256_and_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ), _mm256_set1_ps(1.0f)); }
+	inline Float round(Float v) { return _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	inline Float floor(Float v) { return _mm256_floor_ps(v); }
+	inline Float ldexp(Float v, Float exponent)
+	{
+		__m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(exponent), _mm256_set1_epi32(127)), 23);
+		return _mm256_mul_ps(v, _mm256_castsi256_ps(bits));
+	}
+
+	inline void split(Float v, Float& mantissa, Float& exponent)
+	{
+		__m256i bits = _mm256_castps_si256(v);
+		Float e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+		Float m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+
+		Float large = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+		mantissa = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), large);
+		exponent = _mm256_add_ps(e, _mm256_and_ps(large, _mm256_set1_ps(1.0f)));
+	}
+#elif defined(__SSE2__) || defined(_M_X64)
+	constexpr const char* name = "SSE";
+	constexpr int width = 4;
+	using Float = __m128;
+
+	inline Float load(const float* p) { return _mm_loadu_ps(p); }
+	inline void store(float* p, Float v) { _mm_storeu_ps(p, v); }
+	inline Float broadcast(float v) { return _mm_set1_ps(v); }
+	inline Float zero() { return _mm_setzero_ps(); }
+	inline Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+	inline Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+	inline Float mulAdd(Float a, Float b, Float c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	inline Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	inline Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+	inline Float sqrt(Float v) { return _mm_sqrt_ps(v); }
+	inline Float min(Float a, Float b) { return _mm_min_ps(a, b); }
+	inline Float div(Float a, Float b) { return _mm_div_ps(a, b); }
+	inline Float abs(Float v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+	// SSE2 has no gather, lanes are looked up one by one
+	inline Float lookup(const float* table, Float index)
+	{
+		alignas(16) int lanes[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_cvttps_epi32(index));
+		return _mm_setr_ps(table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]);
+	}
+	inline Float lessEqual(Float a, Float b) { return _mm_and_ps(_mm_cmple_ps(a, b), _mm_set1_ps(1.0f)); }
+	// SSE2 has no rounding instruction, conversion rounds to nearest in default rounding mode
+	inline Float round(Float v) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(v)); }
+	// Truncation rounds negative numbers up, they are moved one down
+	inline Float floor(Float v)
+	{
+		Float truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, v), _mm_set1_ps(1.0f)));
+	}
+	inline Float ldexp(Float v, Float exponent)
+	{
+		__m128i bits = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(exponent), _mm_set1_epi32(127)), 23);
+		return _mm_mul_ps(v, _mm_castsi128_ps(bits));
+	}
+
+	inline void split(Float v, Float& mantissa, Float& exponent)
+	{
+		__m128i bits = _mm_castps_si128(v);
+		Float e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+		Float m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+		// SSE2 has no blend, select by masks
+		Float large = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+		mantissa = _mm_or_ps(_mm_and_ps(large, _mm_mul_ps(m, _mm_set1_ps(0.5f))), _mm_andnot_ps(large, m));
+		exponent = _mm_add_ps(e, _mm_and_ps(large, _mm_set1_ps(1.0f)));
+	}
+#else
+	constexpr const char* name = "scalar";
+	constexpr int width = 1;
+	using Float = float;
+
+	inline Float load(const float* p) { return *p; }
+	inline void store(float* p, Float v) { *p = v; }
+	inline Float broadcast(float v) { return v; }
+	inline Float zero() { return 0.0f; }
+	inline Float add(Float a, Float b) { return a + b; }
+	inline Float mul(Float a, Float b) { return a * b; }
+	inline Float mulAdd(Float a, Float b, Float c) { return a * b + c; }
+	inline Float sub(Float a, Float b) { return a - b; }
+	inline Float max(Float a, Float b) { return std::max(a, b); }
+	inline Float sqrt(Float v) { return std::sqrt(v); }
+	inline Float min(Float a, Float b) { return std::min(a, b); }
+	inline Float div(Float a, Float b) { return a / b; }
+	inline Float abs(Float v) { return std::fabs(v); }
+	inline Float lookup(const float* table, Float index) { return table[static_cast<int>(index)]; }
+	inline Float lessEqual(Float a, Float b) { return a <= b ? 1.0f : 0.0f; }
+	inline Float round(Float v) { return std::nearbyint(v); }
+	inline Float floor(Float v) { return std::floor(v); }
+	inline Float ldexp(Float v, Float exponent) { return std::ldexp(v, static_cast<int>(exponent)); }
+
+	inline void split(Float v, Float& mantissa, Float& exponent)
+	{
+		int e;
+		Float m = std::frexp(v, &e) * 2.0f;
+		e--;
+
+		if (m > 1.41421356f) {
+			m *= 0.5f;
+			e++;
+		}
+
+		mantissa = m;
+		exponent = static_cast<float>(e);
+	}
+#endif
+
+	/// <summary>
+	/// Natural logarithm of positive normal numbers (Cephes polynomial, relative error about 1e-7).
+	/// </summary>
+	inline Float log(Float v)
+	{
+		Float mantissa;
+		Float exponent;
+		split(v, mantissa, exponent);
+
+		Float t = sub(mantissa, broadcast(1.0f));
+		Float t2 = mul(t, t);
+
+		Float p = broadcast(7.0376836292e-2f);
+		p = mulAdd(p, t, broadcast(-1.1514610310e-1f));
+		p = mulAdd(p, t, broadcast(1.1676998740e-1f));
+		p = mulAdd(p, t, broadcast(-1.2420140846e-1f));
+		p = mulAdd(p, t, broadcast(1.4249322787e-1f));
+		p = mulAdd(p, t, broadcast(-1.6668057665e-1f));
+		p = mulAdd(p, t, broadcast(2.0000714765e-1f));
+		p = mulAdd(p, t, broadcast(-2.4999993993e-1f));
+		p = mulAdd(p, t, broadcast(3.3333331174e-1f));
+		p = mul(mul(p, t), t2);
+
+		// ln 2 is split into two parts so that exponent term keeps full precision
+		p = mulAdd(exponent, broadcast(-2.12194440e-4f), p);
+		p = mulAdd(t2, broadcast(-0.5f), p);
+
+		return mulAdd(exponent, broadcast(0.693359375f), add(t, p));
+	}
+
+	/// <summary>
+	/// Exponential function (Cephes polynomial, relative error about 1.2e-7), argument is clamped to <-87.3, 88.3>
+	/// so that results stay normal numbers.
+	/// </summary>
+	inline Float exp(Float v)
+	{
+		v = min(max(v, broadcast(-87.3f)), broadcast(88.3f));
+
+		// v = n * ln 2 + r, ln 2 is split into two parts so that r keeps full precision
+		Float n = round(mul(v, broadcast(1.44269504f)));
+		Float r = mulAdd(n, broadcast(-0.693359375f), v);
+		r = mulAdd(n, broadcast(2.12194440e-4f), r);
+
+		Float p = broadcast(1.9875691500e-4f);
+		p = mulAdd(p, r, broadcast(1.3981999507e-3f));
+		p = mulAdd(p, r, broadcast(8.3334519073e-3f));
+		p = mulAdd(p, r, broadcast(4.1665795894e-2f));
+		p = mulAdd(p, r, broadcast(1.6666665459e-1f));
+		p = mulAdd(p, r, broadcast(5.0000001201e-1f));
+		p = mulAdd(p, mul(r, r), add(r, broadcast(1.0f)));
+
+		return ldexp(p, n);
+	}
+
+	/// <summary>
+	/// Power of non-negative base as exp(exponent * log(base)). Zero base gives 0 for positive exponents
+	/// (as std::pow), for other exponents it is replaced by smallest normal number (1 for zero exponent,
+	/// large value for negative ones).
+	/// </summary>
+	inline Float pow(Float base, Float exponent)
+	{
+		const Float zero = Simd::zero();
+		const Float one = broadcast(1.0f);
+		const Float power = exp(mul(exponent, log(max(base, broadcast(1.17549435e-38f)))));
+
+		// 1 in lanes of zero base and positive exponent, where finite power is replaced by 0
+		const Float zeroBase = mul(lessEqual(base, zero), sub(one, lessEqual(exponent, zero)));
+		return mulAdd(zeroBase, sub(zero, power), power);
+	}
+
+	/// <summary>
+	/// Largest of vector lanes.
+	/// </summary>
+	inline float reduceMax(Float v)
+	{
+		float lanes[width];
+		store(lanes, v);
+
+		return *std::max_element(lanes, lanes + width);
+	}
+}
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "Spectrum.hpp"
+#include "Simd.hpp"
+#include "Utils.hpp"
+
+namespace Spectrum
+{
+	/// <summary>
+	/// Writes log10(1 + sqrt(power)) of contiguous run of values, returns largest magnitude.
+	/// </summary>
+	static float LogMagnitudeSegment(const float* power, float* destination, int count)
+	{
+		const Simd::Float one = Simd::broadcast(1.0f);
+		const Simd::Float log10e = Simd::broadcast(0.434294482f);
+		Simd::Float maximum = Simd::zero();
+
+		int x = 0;
+		for (; x + Simd::width <= count; x += Simd::width) {
+			Simd::Float magnitude = Simd::sqrt(Simd::load(power + x));
+			maximum = Simd::max(maximum, magnitude);
+			Simd::store(destination + x, Simd::mul(Simd::log(Simd::add(one, magnitude)), log10e));
+		}
+
+		float result = Simd::reduceMax(maximum);
+		for (; x < count; x++) {
+			float magnitude = std::sqrt(power[x]);
+			result = std::max(result, magnitude);
+			destination[x] = std::log10(1.0f + magnitude);
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// Converts squared magnitudes of one spectrum row to displayed values of destination row,
+	/// shift of columns is done by two block writes instead of per pixel modulo.
+	/// </summary>
+	static float LogMagnitudeRow(const float* power, float* destinationRow, int width)
+	{
+		const int shift = DisplayShiftX(width) % width;
+
+		// Source columns <0, width - shift) go to <shift, width), the rest wraps around to the beginning
+		float maximum = LogMagnitudeSegment(power, destinationRow + shift, width - shift);
+		return std::max(maximum, LogMagnitudeSegment(power + width - shift, destinationRow, shift));
+	}
+
+	/// <summary>
+	/// Runs row conversion in parallel bands, fill(y, power) provides squared magnitudes of row y.
+	/// </summary>
+	template <typename Fill>
+	static double LogMagnitudeRows(int width, int height, float* destination, Fill fill)
+	{
+		const int shiftY = DisplayShiftY(height);
+		std::mutex maximumMutex;
+		float maximum = 0.0f;
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			std::vector<float> power(width);
+			float bandMaximum = 0.0f;
+
+			for (int y = begin; y < end; y++) {
+				fill(y, power.data());
+
+				float* destinationRow = destination + static_cast<size_t>((y + shiftY) % height) * width;
+				bandMaximum = std::max(bandMaximum, LogMagnitudeRow(power.data(), destinationRow, width));
+			}
+
+			std::lock_guard<std::mutex> lock(maximumMutex);
+			maximum = std::max(maximum, bandMaximum);
+		});
+
+		return maximum;
+	}
+
+	double LogMagnitude(const fftw_complex* spectrum, int width, int height, float* destination)
+	{
+		return LogMagnitudeRows(width, height, destination, [spectrum, width](int y, float* power) {
+			const fftw_complex* row = spectrum + static_cast<size_t>(y) * width;
+
+			for (int x = 0; x < width; x++) {
+				power[x] = static_cast<float>(row[x][0] * row[x][0] + row[x][1] * row[x][1]);
+			}
+		});
+	}
+
+	double LogMagnitudeHalf(const fftwf_complex* spectrum, int width, int height, float* destination)
+	{
+		const int halfWidth = width / 2 + 1;
+
+		return LogMagnitudeRows(width, height, destination, [spectrum, width, height, halfWidth](int y, float* power) {
+			const fftwf_complex* row = spectrum + static_cast<size_t>(y) * halfWidth;
+			// Missing columns are complex conjugates of stored ones: F(x, y) = F*(width - x, height - y)
+			const fftwf_complex* mirrorRow = spectrum + static_cast<size_t>((height - y) % height) * halfWidth;
+
+			for (int x = 0; x < halfWidth; x++) {
+				power[x] = row[x][0] * row[x][0] + row[x][1] * row[x][1];
+			}
+			for (int x = halfWidth; x < width; x++) {
+				power[x] = mirrorRow[width - x][0] * mirrorRow[width - x][0] + mirrorRow[width - x][1] * mirrorRow[width - x][1];
+			}
+		});
+	}
+
+	/// <summary>
+	/// Filter parameters converted to squared distances used by mask formulas.
+	/// </summary>
+	struct PreparedFilter {
+		FilterType type;
+		FilterShape shape;
+		int order;
+		float cutoff2;
+		float inner2;
+		float outer2;
+		float bandWidth2;
+		float notchU;
+		float notchV;
+	};
+
+	static PreparedFilter Prepare(const Filter& filter)
+	{
+		// Zero cutoff or band width would divide zero by zero at zero frequency
+		const float cutoff = std::max(filter.cutoff, 1e-6f);
+		const float bandWidth = std::max(filter.bandWidth, 1e-6f);
+		const float inner = std::max(0.0f, cutoff - bandWidth / 2.0f);
+		const float outer = cutoff + bandWidth / 2.0f;
+
+		return {
+			filter.type,
+			filter.shape,
+			std::max(1, filter.order),
+			cutoff * cutoff,
+			inner * inner,
+			outer * outer,
+			bandWidth * bandWidth,
+			filter.notchU,
+			filter.notchV
+		};
+	}
+
+	/// <summary>
+	/// Computes 1 / (1 + value^order).
+	/// </summary>
+	static inline Simd::Float ButterworthResponse(Simd::Float value, int order)
+	{
+		Simd::Float power = value;
+		for (int i = 1; i < order; i++) {
+			power = Simd::mul(power, value);
+		}
+
+		const Simd::Float one = Simd::broadcast(1.0f);
+		return Simd::div(one, Simd::add(one, power));
+	}
+
+	/// <summary>
+	/// Low pass response for squared distance from center of filter.
+	/// </summary>
+	static inline Simd::Float LowPass(const PreparedFilter& filter, Simd::Float distance2)
+	{
+		switch (filter.shape) {
+		case FilterShape::Ideal:
+			return Simd::lessEqual(distance2, Simd::broadcast(filter.cutoff2));
+		case FilterShape::Butterworth:
+			return ButterworthResponse(Simd::div(distance2, Simd::broadcast(filter.cutoff2)), filter.order);
+		default:
+			return Simd::exp(Simd::div(distance2, Simd::broadcast(-2.0f * filter.cutoff2)));
+		}
+	}
+
+	/// <summary>
+	/// Band pass response for squared distance from zero frequency.
+	/// </summary>
+	static inline Simd::Float BandPass(const PreparedFilter& filter, Simd::Float distance2)
+	{
+		if (filter.shape == FilterShape::Ideal) {
+			return Simd::mul(
+				Simd::lessEqual(Simd::broadcast(filter.inner2), distance2),
+				Simd::lessEqual(distance2, Simd::broadcast(filter.outer2))
+			);
+		}
+
+		// ((D^2 - C^2) / (D * W))^2, zero on band center and infinite at zero frequency
+		Simd::Float offset = Simd::sub(distance2, Simd::broadcast(filter.cutoff2));
+		Simd::Float ratio = Simd::div(Simd::mul(offset, offset), Simd::mul(distance2, Simd::broadcast(filter.bandWidth2)));
+
+		if (filter.shape == FilterShape::Butterworth) {
+			return ButterworthResponse(ratio, filter.order);
+		}
+
+		return Simd::exp(Simd::sub(Simd::zero(), ratio));
+	}
+
+	/// <summary>
+	/// Value of filter mask for frequencies (u, v) in cycles per pixel.
+	/// </summary>
+	static inline Simd::Float Response(const PreparedFilter& filter, Simd::Float u, Simd::Float v)
+	{
+		const Simd::Float one = Simd::broadcast(1.0f);
+		const Simd::Float distance2 = Simd::mulAdd(u, u, Simd::mul(v, v));
+
+		switch (filter.type) {
+		case FilterType::LowPass:
+			return LowPass(filter, distance2);
+		case FilterType::HighPass:
+			return Simd::sub(one, LowPass(filter, distance2));
+		case FilterType::BandPass:
+			return BandPass(filter, distance2);
+		case FilterType::BandReject:
+			return Simd::sub(one, BandPass(filter, distance2));
+		default: {
+			// Real image has conjugate symmetric spectrum, so both (u0, v0) and (-u0, -v0) are rejected
+			Simd::Float du = Simd::sub(u, Simd::broadcast(filter.notchU));
+			Simd::Float dv = Simd::sub(v, Simd::broadcast(filter.notchV));
+			Simd::Float su = Simd::add(u, Simd::broadcast(filter.notchU));
+			Simd::Float sv = Simd::add(v, Simd::broadcast(filter.notchV));
+
+			Simd::Float first = Simd::sub(one, LowPass(filter, Simd::mulAdd(du, du, Simd::mul(dv, dv))));
+			Simd::Float second = Simd::sub(one, LowPass(filter, Simd::mulAdd(su, su, Simd::mul(sv, sv))));
+			return Simd::mul(first, second);
+		}
+		}
+	}
+
+	/// <summary>
+	/// Signed frequency in cycles per pixel of index of unshifted spectrum.
+	/// </summary>
+	static inline float Frequency(int index, int size)
+	{
+		return static_cast<float>(index <= size / 2 ? index : index - size) / size;
+	}
+
+	/// <summary>
+	/// Multiplies count interleaved (re, im) pairs by their mask values, written over flat array of values
+	/// so that compiler vectorizes it.
+	/// </summary>
+	template <typename Complex>
+	static inline void MultiplyByMask(Complex* elements, const float* mask, int count)
+	{
+		using Value = std::remove_extent_t<Complex>;
+		Value* values = reinterpret_cast<Value*>(elements);
+
+		for (int i = 0; i < 2 * count; i++) {
+			values[i] *= mask[i / 2];
+		}
+	}
+
+	/// <summary>
+	/// Multiplies rows of spectrum by filter mask, mask is computed for Simd::width elements at once.
+	/// </summary>
+	template <typename Complex>
+	static void FilterRows(Complex* spectrum, int rowLength, int width, int height, const Filter& filter)
+	{
+		const PreparedFilter prepared = Prepare(filter);
+
+		Utils::ParallelBands(height, [&](int begin, int end) {
+			float offsets[Simd::width];
+			float mask[Simd::width];
+			for (int lane = 0; lane < Simd::width; lane++) {
+				offsets[lane] = static_cast<float>(lane);
+			}
+
+			const Simd::Float laneOffsets = Simd::load(offsets);
+			const Simd::Float one = Simd::broadcast(1.0f);
+			const Simd::Float size = Simd::broadcast(static_cast<float>(width));
+			const Simd::Float nyquist = Simd::broadcast(static_cast<float>(width / 2));
+			const Simd::Float lastIndex = Simd::broadcast(static_cast<float>(rowLength - 1));
+
+			// Same as Frequency: indices past Nyquist frequency are negative frequencies
+			auto frequencies = [&](Simd::Float index) {
+				Simd::Float wrap = Simd::mul(Simd::sub(one, Simd::lessEqual(index, nyquist)), size);
+				return Simd::div(Simd::sub(index, wrap), size);
+			};
+
+			for (int y = begin; y < end; y++) {
+				const Simd::Float v = Simd::broadcast(Frequency(y, height));
+				Complex* row = spectrum + static_cast<size_t>(y) * rowLength;
+
+				int x0 = 0;
+				for (; x0 + Simd::width <= rowLength; x0 += Simd::width) {
+					const Simd::Float u = frequencies(Simd::add(Simd::broadcast(static_cast<float>(x0)), laneOffsets));
+					Simd::store(mask, Response(prepared, u, v));
+					MultiplyByMask(row + x0, mask, Simd::width);
+				}
+
+				if (x0 < rowLength) {
+					// Lanes behind end of row repeat the last element, their mask is not used
+					const Simd::Float index = Simd::min(Simd::add(Simd::broadcast(static_cast<float>(x0)), laneOffsets), lastIndex);
+					Simd::store(mask, Response(prepared, frequencies(index), v));
+					MultiplyByMask(row + x0, mask, rowLength - x0);
+				}
+			}
+		});
+	}
+
+	void ApplyFilter(fftw_complex* spectrum, int width, int height, const Filter& filter)
+	{
+		FilterRows(spectrum, width, width, height, filter);
+	}
+
+	void ApplyFilterHalf(fftwf_complex* spectrum, int width, int height, const Filter& filter)
+	{
+		FilterRows(spectrum, width / 2 + 1, width, height, filter);
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <fftw3.h>
+
+/// <summary>
+/// Namespace with kernels preparing spectra computed by FFTW for displaying.
+/// </summary>
+namespace Spectrum
+{
+	/// <summary>
+	/// Horizontal shift of displayed spectrum (frequency 0 is moved to this column).
+	/// </summary>
+	inline int DisplayShiftX(int width) { return width / 2 + 1; }
+
+	/// <summary>
+	/// Vertical shift of displayed spectrum (frequency 0 is moved to this row).
+	/// </summary>
+	inline int DisplayShiftY(int height) { return height / 2; }
+
+	/// <summary>
+	/// Converts full complex spectrum to displayable log10(1 + magnitude) image with zero frequency in center.
+	///
+	/// Single fused pass: magnitude of each element is computed once, logarithm is vectorized and every
+	/// source row is written as two contiguous segments of shifted destination row. Rows run in parallel.
+	/// </summary>
+	/// <param name="spectrum">Spectrum of height rows of width elements</param>
+	/// <param name="width">Width of image</param>
+	/// <param name="height">Height of image</param>
+	/// <param name="destination">Output image of width * height values</param>
+	/// <returns>Largest magnitude of spectrum</returns>
+	double LogMagnitude(const fftw_complex* spectrum, int width, int height, float* destination);
+
+	/// <summary>
+	/// Same as LogMagnitude for Hermitian half spectrum of real-to-complex transform (height rows of width / 2 + 1),
+	/// missing columns are mirrored from conjugate elements.
+	/// </summary>
+	double LogMagnitudeHalf(const fftwf_complex* spectrum, int width, int height, float* destination);
+
+	/// <summary> Which frequencies filter passes </summary>
+	enum class FilterType {
+		LowPass,
+		HighPass,
+		/// <summary> Ring of frequencies with radius cutoff and width bandWidth </summary>
+		BandPass,
+		/// <summary> Complement of band pass </summary>
+		BandReject,
+		/// <summary> Rejects circle around (notchU, notchV) and its conjugate symmetric counterpart </summary>
+		Notch
+	};
+
+	/// <summary> Transition between passed and rejected frequencies </summary>
+	enum class FilterShape {
+		/// <summary> Sharp cut </summary>
+		Ideal,
+		/// <summary> 1 / (1 + (D / cutoff)^(2 * order)) </summary>
+		Butterworth,
+		/// <summary> exp(-D^2 / (2 * cutoff^2)) </summary>
+		Gaussian
+	};
+
+	/// <summary>
+	/// Parameters of frequency domain filter (formulas as in Gonzalez, Woods: Digital Image Processing).
+	///
+	/// Frequencies are normalized to cycles per pixel (0.5 is Nyquist frequency) in both directions,
+	/// so the same filter gives the same result for images of any size.
+	/// </summary>
+	struct Filter {
+		FilterType type = FilterType::LowPass;
+		FilterShape shape = FilterShape::Gaussian;
+		/// <summary> Cutoff of low and high pass, radius of band center or radius of notch </summary>
+		float cutoff = 0.1f;
+		/// <summary> Width of band of band pass and band reject </summary>
+		float bandWidth = 0.05f;
+		/// <summary> Order of Butterworth filter </summary>
+		int order = 2;
+		/// <summary> Horizontal frequency of notch center </summary>
+		float notchU = 0.0f;
+		/// <summary> Vertical frequency of notch center </summary>
+		float notchV = 0.0f;
+	};
+
+	/// <summary>
+	/// Multiplies full complex spectrum (unshifted, as computed by FFTW) by filter in place.
+	///
+	/// Mask is evaluated analytically for each element (no mask buffer), vectorized along rows,
+	/// rows run in parallel.
+	/// </summary>
+	/// <param name="spectrum">Spectrum of height rows of width elements</param>
+	/// <param name="width">Width of image</param>
+	/// <param name="height">Height of image</param>
+	/// <param name="filter">Filter to apply</param>
+	void ApplyFilter(fftw_complex* spectrum, int width, int height, const Filter& filter);
+
+	/// <summary>
+	/// Same as ApplyFilter for Hermitian half spectrum of real-to-complex transform (height rows of width / 2 + 1).
+	/// </summary>
+	void ApplyFilterHalf(fftwf_complex* spectrum, int width, int height, const Filter& filter);
+}
@@ -0,0 +1,156 @@
+#include <iostream>
+#include <algorithm>
+
+#include "SpectrumStack.hpp"
+#include "FFTPlans.hpp"
+#include "Spectrum.hpp"
+#include "Utils.hpp"
+
+SpectrumStack::~SpectrumStack() {
+    if (spectra != nullptr) {
+        fftwf_free(spectra);
+    }
+}
+
+size_t SpectrumStack::frameLength() const {
+    return (size_t)height * (width / 2 + 1);
+}
+
+bool SpectrumStack::compute(const std::vector<Image*>& images, int threads) {
+    if (images.empty()) {
+        std::cout << "Spectrum stack needs at least one image" << std::endl;
+        return false;
+    }
+
+    for (Image* image : images) {
+        if (image->width != images[0]->width || image->height != images[0]->height) {
+            std::cout << "Images in spectrum stack must have the same size" << std::endl;
+            return false;
+        }
+    }
+
+    for (Image* image : images) {
+        image->evaluate();
+    }
+
+    // Every plane is transformed as a frame of its own
+    std::vector<const float*> planes;
+    channels.clear();
+    for (Image* image : images) {
+        channels.push_back(image->channels);
+        for (int c = 0; c < image->channels; c++) {
+            planes.push_back(image->plane(c));
+        }
+    }
+
+    // Buffer is reused when stack of the same shape is computed again
+    if (spectra == nullptr || width != images[0]->width || height != images[0]->height || count != (int)planes.size()) {
+        if (spectra != nullptr) {
+            fftwf_free(spectra);
+        }
+
+        width = images[0]->width;
+        height = images[0]->height;
+        count = (int)planes.size();
+
+        spectra = fftwf_alloc_complex(frameLength() * count);
+    }
+
+    // In-place transform reads real rows padded to width of spectrum rows
+    const int paddedWidth = 2 * (width / 2 + 1);
+    float* real = (float*)spectra;
+
+    Utils::ParallelBands(count * height, [&](int begin, int end) {
+        for (int row = begin; row < end; row++) {
+            const float* source = planes[row / height] + (size_t)(row % height) * width;
+            std::copy(source, source + width, real + (size_t)row * paddedWidth);
+        }
+    });
+
+    fftwf_plan plan = FFTPlans::GetFloatMany(width, height, count, FFTPlans::Direction::Forward, FFTPlans::Domain::Real, spectra, spectra, threads);
+    if (plan == nullptr) {
+        std::cout << "Cannot create plan of spectrum stack" << std::endl;
+        return false;
+    }
+
+    fftwf_execute_dft_r2c(plan, real, spectra);
+
+    return true;
+}
+
+fftwf_complex* SpectrumStack::frame(int index) {
+    if (spectra == nullptr || index < 0 || index >= count) {
+        return nullptr;
+    }
+
+    return spectra + frameLength() * index;
+}
+
+void SpectrumStack::applyFilter(const Spectrum::Filter& filter) {
+    for (int i = 0; i < count; i++) {
+        Spectrum::ApplyFilterHalf(frame(i), width, height, filter);
+    }
+}
+
+std::vector<float> SpectrumStack::displaySpectrum(int index) const {
+    if (spectra == nullptr || index < 0 || index >= count) {
+        return {};
+    }
+
+    std::vector<float> spectrum((size_t)width * height);
+    Spectrum::LogMagnitudeHalf(spectra + frameLength() * index, width, height, spectrum.data());
+
+    return spectrum;
+}
+
+std::vector<std::vector<float>> SpectrumStack::reconstructImages(int threads) const {
+    if (spectra == nullptr) {
+        return {};
+    }
+
+    const size_t length = frameLength() * count;
+    const int paddedWidth = 2 * (width / 2 + 1);
+
+    // Complex-to-real transform destroys its input, so it runs in place on a copy
+    fftwf_complex* restored = fftwf_alloc_complex(length);
+    std::copy(&spectra[0][0], &spectra[0][0] + 2 * length, &restored[0][0]);
+
+    fftwf_plan plan = FFTPlans::GetFloatMany(width, height, count, FFTPlans::Direction::Backward, FFTPlans::Domain::Real, restored, restored, threads);
+    if (plan == nullptr) {
+        std::cout << "Cannot create plan of spectrum stack" << std::endl;
+        fftwf_free(restored);
+        return {};
+    }
+
+    fftwf_execute_dft_c2r(plan, restored, (float*)restored);
+
+    // Consecutive frames of image are its planes
+    const size_t planeSize = (size_t)width * height;
+    std::vector<std::vector<float>> images;
+    std::vector<float*> planes;
+    images.reserve(channels.size());
+    for (int imageChannels : channels) {
+        images.emplace_back(planeSize * imageChannels);
+        for (int c = 0; c < imageChannels; c++) {
+            planes.push_back(images.back().data() + c * planeSize);
+        }
+    }
+
+    const float* real = (const float*)restored;
+    const float scale = 1.0f / ((float)width * height);
+
+    Utils::ParallelBands(count * height, [&](int begin, int end) {
+        for (int row = begin; row < end; row++) {
+            const float* source = real + (size_t)row * paddedWidth;
+            float* destination = planes[row / height] + (size_t)(row % height) * width;
+
+            for (int x = 0; x < width; x++) {
+                destination[x] = source[x] * scale;
+            }
+        }
+    });
+
+    fftwf_free(restored);
+
+    return images;
+}
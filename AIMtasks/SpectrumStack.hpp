@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+
+#include <fftw3.h>
+
+#include "Image.hpp"
+#include "Spectrum.hpp"
+
+/// <summary>
+/// Spectra of stack of same sized images (e.g. frames of time-lapse) computed by one batched FFT.
+/// Every plane of multi-channel image is a frame of its own, planes of one image are consecutive frames.
+///
+/// Uses single precision real-to-complex transform (like Image::SpectrumMode::REAL_FLOAT), Hermitian halves
+/// of all frames are stored contiguously frame after frame. Transform runs in place, so the whole stack
+/// takes about 4 B per pixel and one cached plan serves all frames.
+/// </summary>
+class SpectrumStack {
+public:
+    /// <summary> Width of frames </summary>
+    int width = 0;
+    /// <summary> Height of frames </summary>
+    int height = 0;
+    /// <summary> Number of frames (planes of all images) </summary>
+    int count = 0;
+    /// <summary> Number of channels of each image of stack </summary>
+    std::vector<int> channels;
+
+    SpectrumStack() = default;
+    SpectrumStack(const SpectrumStack&) = delete;
+    SpectrumStack& operator=(const SpectrumStack&) = delete;
+    ~SpectrumStack();
+
+    /// <summary>
+    /// Computes spectra of all given images, replaces previous content of stack.
+    /// </summary>
+    /// <param name="images">Images of the same size</param>
+    /// <param name="threads">Number of FFTW threads, 0 uses global setting (FFTPlans::SetThreads).</param>
+    /// <returns>False when there are no images, their sizes differ or transform cannot be planned.</returns>
+    bool compute(const std::vector<Image*>& images, int threads = 0);
+
+    /// <summary>
+    /// Returns Hermitian half of spectrum of given frame (height rows of width / 2 + 1 values), it can be modified.
+    /// </summary>
+    /// <returns>Null when spectra were not computed or index is out of range.</returns>
+    fftwf_complex* frame(int index);
+
+    /// <summary>
+    /// Filters spectra of all frames in place.
+    /// </summary>
+    void applyFilter(const Spectrum::Filter& filter);
+
+    /// <summary>
+    /// Creates displayable spectrum of given frame (same as spectrum of Image).
+    /// </summary>
+    /// <returns>Empty vector when spectra were not computed or index is out of range.</returns>
+    std::vector<float> displaySpectrum(int index) const;
+
+    /// <summary>
+    /// Reconstructs all frames from their (possibly modified) spectra using one batched Inverse FT.
+    /// </summary>
+    /// <param name="threads">Number of FFTW threads, 0 uses global setting (FFTPlans::SetThreads).</param>
+    /// <returns>Image data (all planes) of each image, empty when spectra were not computed.</returns>
+    std::vector<std::vector<float>> reconstructImages(int threads = 0) const;
+
+private:
+    /// <summary> Hermitian halves of spectra of all frames </summary>
+    fftwf_complex* spectra = nullptr;
+
+    /// <summary>
+    /// Number of complex values of spectrum of one frame.
+    /// </summary>
+    size_t frameLength() const;
+};
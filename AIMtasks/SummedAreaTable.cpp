@@ -0,0 +1,203 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#include "SummedAreaTable.hpp"
+#include "Utils.hpp"
+
+/// <summary>
+/// Number of columns of strip processed by one task of vertical prefix scan.
+/// </summary>
+static const int ColumnStripWidth = 256;
+
+/// <summary>
+/// Fills table (height + 1 rows of width + 1 values) by prefix sums of value(x) of data rows.
+/// </summary>
+template <typename Value>
+static void BuildTable(const float* data, int width, int height, std::vector<double>& table, Value value) {
+    const size_t stride = (size_t)width + 1;
+    table.assign(stride * (height + 1), 0.0);
+
+    // Prefix sums of rows, every row is independent
+    Utils::ParallelBands(height, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const float* row = data + (size_t)y * width;
+            double* tableRow = table.data() + (y + 1) * stride + 1;
+
+            double sum = 0.0;
+            for (int x = 0; x < width; x++) {
+                sum += value(row[x]);
+                tableRow[x] = sum;
+            }
+        }
+    });
+
+    // Prefix sums of columns, strips of columns are independent and rows of strip are read contiguously
+    const int strips = (int)((stride + ColumnStripWidth - 1) / ColumnStripWidth);
+
+    Utils::ParallelBands(strips, [&](int begin, int end) {
+        const size_t first = (size_t)begin * ColumnStripWidth;
+        const size_t last = std::min(stride, (size_t)end * ColumnStripWidth);
+
+        for (int y = 1; y <= height; y++) {
+            const double* previous = table.data() + (y - 1) * stride;
+            double* current = table.data() + y * stride;
+
+            for (size_t x = first; x < last; x++) {
+                current[x] += previous[x];
+            }
+        }
+    });
+}
+
+/// <summary>
+/// Sum of rectangle <x0, x1> x <y0, y1> of table with given stride.
+/// </summary>
+static inline double RectangleSum(const std::vector<double>& table, size_t stride, int x0, int y0, int x1, int y1) {
+    const double* top = table.data() + y0 * stride;
+    const double* bottom = table.data() + (y1 + 1) * stride;
+
+    return bottom[x1 + 1] - bottom[x0] - top[x1 + 1] + top[x0];
+}
+
+void SummedAreaTable::build(const std::vector<float>& data, int width, int height, bool withSquares) {
+    build(data.data(), width, height, withSquares);
+}
+
+void SummedAreaTable::build(const float* data, int width, int height, bool withSquares) {
+    this->width = width;
+    this->height = height;
+
+    BuildTable(data, width, height, sums, [](float value) { return (double)value; });
+
+    if (withSquares) {
+        BuildTable(data, width, height, squares, [](float value) { return (double)value * value; });
+    } else {
+        squares.clear();
+    }
+}
+
+bool SummedAreaTable::build(Image& image, bool withSquares) {
+    if (image.channels > 1) {
+        std::cout << "Summed-area table is built of one plane, build it of each plane of multi-channel image" << std::endl;
+        return false;
+    }
+
+    image.evaluate();
+    build(image.data, image.width, image.height, withSquares);
+
+    return true;
+}
+
+bool SummedAreaTable::hasSquares() const {
+    return !squares.empty();
+}
+
+double SummedAreaTable::sum(int x0, int y0, int x1, int y1) const {
+    return RectangleSum(sums, (size_t)width + 1, x0, y0, x1, y1);
+}
+
+double SummedAreaTable::squaredSum(int x0, int y0, int x1, int y1) const {
+    return RectangleSum(squares, (size_t)width + 1, x0, y0, x1, y1);
+}
+
+void SummedAreaTable::boxBlur(int radiusX, int radiusY, std::vector<float>& destination) const {
+    const size_t stride = (size_t)width + 1;
+    destination.resize((size_t)width * height);
+
+    Utils::ParallelBands(height, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const int y0 = std::max(y - radiusY, 0);
+            const int y1 = std::min(y + radiusY, height - 1);
+            float* out = destination.data() + (size_t)y * width;
+
+            for (int x = 0; x < width; x++) {
+                const int x0 = std::max(x - radiusX, 0);
+                const int x1 = std::min(x + radiusX, width - 1);
+                const double area = (double)(x1 - x0 + 1) * (y1 - y0 + 1);
+
+                out[x] = (float)(RectangleSum(sums, stride, x0, y0, x1, y1) / area);
+            }
+        }
+    });
+}
+
+void SummedAreaTable::localMean(int radius, std::vector<float>& destination) const {
+    boxBlur(radius, radius, destination);
+}
+
+template <typename Function>
+void SummedAreaTable::forEachWindow(int radius, Function function) const {
+    const size_t stride = (size_t)width + 1;
+
+    Utils::ParallelBands(height, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const int y0 = std::max(y - radius, 0);
+            const int y1 = std::min(y + radius, height - 1);
+
+            for (int x = 0; x < width; x++) {
+                const int x0 = std::max(x - radius, 0);
+                const int x1 = std::min(x + radius, width - 1);
+                const double area = (double)(x1 - x0 + 1) * (y1 - y0 + 1);
+
+                const double mean = RectangleSum(sums, stride, x0, y0, x1, y1) / area;
+                // Rounding can make variance of flat window slightly negative
+                const double variance = std::max(0.0, RectangleSum(squares, stride, x0, y0, x1, y1) / area - mean * mean);
+
+                function((size_t)y * width + x, mean, variance);
+            }
+        }
+    });
+}
+
+bool SummedAreaTable::localVariance(int radius, std::vector<float>& destination) const {
+    if (!hasSquares()) {
+        std::cout << "Local variance needs summed-area table of squared values" << std::endl;
+        return false;
+    }
+
+    destination.resize((size_t)width * height);
+    forEachWindow(radius, [&destination](size_t index, double /*mean*/, double variance) {
+        destination[index] = (float)variance;
+    });
+
+    return true;
+}
+
+bool SummedAreaTable::niblackThreshold(const std::vector<float>& data, int radius, float k, std::vector<float>& destination) const {
+    destination.resize((size_t)width * height);
+    return niblackThreshold(data.data(), radius, k, destination.data());
+}
+
+bool SummedAreaTable::niblackThreshold(const float* data, int radius, float k, float* destination) const {
+    if (!hasSquares()) {
+        std::cout << "Niblack threshold needs summed-area table of squared values" << std::endl;
+        return false;
+    }
+
+    forEachWindow(radius, [data, destination, k](size_t index, double mean, double variance) {
+        const double threshold = mean + k * std::sqrt(variance);
+        destination[index] = data[index] < threshold ? 0.0f : 1.0f;
+    });
+
+    return true;
+}
+
+bool SummedAreaTable::sauvolaThreshold(const std::vector<float>& data, int radius, float k, float dynamicRange, std::vector<float>& destination) const {
+    destination.resize((size_t)width * height);
+    return sauvolaThreshold(data.data(), radius, k, dynamicRange, destination.data());
+}
+
+bool SummedAreaTable::sauvolaThreshold(const float* data, int radius, float k, float dynamicRange, float* destination) const {
+    if (!hasSquares()) {
+        std::cout << "Sauvola threshold needs summed-area table of squared values" << std::endl;
+        return false;
+    }
+
+    forEachWindow(radius, [data, destination, k, dynamicRange](size_t index, double mean, double variance) {
+        const double threshold = mean * (1.0 + k * (std::sqrt(variance) / dynamicRange - 1.0));
+        destination[index] = data[index] < threshold ? 0.0f : 1.0f;
+    });
+
+    return true;
+}
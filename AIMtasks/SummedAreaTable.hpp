@@ -0,0 +1,128 @@
+#pragma once
+
+#include <vector>
+
+#include "Image.hpp"
+
+/// <summary>
+/// Summed-area table (integral image) of image data, sum of any rectangle is read in constant time.
+///
+/// Sums are stored in double, rounding error of the largest sums of even 16k x 16k images stays far
+/// below float precision of pixels, so no compensated summation is needed. Table has one extra zero row
+/// and column, so that queries do not branch on image border. Optional table of squared values gives
+/// local variance.
+/// </summary>
+class SummedAreaTable {
+public:
+    /// <summary> Width of image </summary>
+    int width = 0;
+    /// <summary> Height of image </summary>
+    int height = 0;
+
+    SummedAreaTable() = default;
+
+    /// <summary>
+    /// Builds table of given image data, replaces previous content.
+    ///
+    /// Two pass scan: prefix sums of rows run in parallel over rows, then prefix sums of columns
+    /// run in parallel over strips of columns.
+    /// </summary>
+    /// <param name="data">Image data of height rows of width values</param>
+    /// <param name="width">Width of image</param>
+    /// <param name="height">Height of image</param>
+    /// <param name="withSquares">Whether to build table of squared values too (needed for variance)</param>
+    void build(const std::vector<float>& data, int width, int height, bool withSquares = false);
+
+    /// <summary>
+    /// Builds table of raw buffer of width * height values.
+    /// </summary>
+    void build(const float* data, int width, int height, bool withSquares = false);
+
+    /// <summary>
+    /// Builds table of grayscale image data (recorded operations of image are applied first), planes of
+    /// multi-channel image need table each, built from Image::plane.
+    /// </summary>
+    /// <returns>False when image has more than one channel.</returns>
+    bool build(Image& image, bool withSquares = false);
+
+    /// <summary>
+    /// Whether table of squared values was built.
+    /// </summary>
+    bool hasSquares() const;
+
+    /// <summary>
+    /// Sum of values in rectangle <x0, x1> x <y0, y1> (inclusive, must lie within image).
+    /// </summary>
+    double sum(int x0, int y0, int x1, int y1) const;
+
+    /// <summary>
+    /// Sum of squared values in rectangle <x0, x1> x <y0, y1> (inclusive, must lie within image).
+    /// </summary>
+    double squaredSum(int x0, int y0, int x1, int y1) const;
+
+    /// <summary>
+    /// Averages window of (2 * radiusX + 1) x (2 * radiusY + 1) pixels around each pixel,
+    /// window is cropped by image border and average is taken over pixels within image.
+    /// </summary>
+    /// <param name="radiusX">Horizontal radius of window</param>
+    /// <param name="radiusY">Vertical radius of window</param>
+    /// <param name="destination">Vector where to save blurred image</param>
+    void boxBlur(int radiusX, int radiusY, std::vector<float>& destination) const;
+
+    /// <summary>
+    /// Mean of square window of (2 * radius + 1)^2 pixels around each pixel (cropped by image border).
+    /// </summary>
+    void localMean(int radius, std::vector<float>& destination) const;
+
+    /// <summary>
+    /// Variance of square window around each pixel, needs table of squared values.
+    /// </summary>
+    /// <returns>False when table of squared values was not built.</returns>
+    bool localVariance(int radius, std::vector<float>& destination) const;
+
+    /// <summary>
+    /// Binarizes data by Niblack's threshold mean + k * deviation of square window around each pixel,
+    /// needs table of squared values of the same data.
+    /// </summary>
+    /// <param name="data">Image data the table was built from</param>
+    /// <param name="radius">Radius of window</param>
+    /// <param name="k">Weight of deviation, usually -0.2 for dark text on light background</param>
+    /// <param name="destination">Vector where to save binary image (0 below threshold, 1 elsewhere)</param>
+    /// <returns>False when table of squared values was not built.</returns>
+    bool niblackThreshold(const std::vector<float>& data, int radius, float k, std::vector<float>& destination) const;
+
+    /// <summary>
+    /// Niblack's threshold of raw buffer into destination of width * height values.
+    /// </summary>
+    bool niblackThreshold(const float* data, int radius, float k, float* destination) const;
+
+    /// <summary>
+    /// Binarizes data by Sauvola's threshold mean * (1 + k * (deviation / dynamicRange - 1)) of square window
+    /// around each pixel, needs table of squared values of the same data.
+    /// </summary>
+    /// <param name="data">Image data the table was built from</param>
+    /// <param name="radius">Radius of window</param>
+    /// <param name="k">Sensitivity, usually 0.2 - 0.5</param>
+    /// <param name="dynamicRange">Largest deviation, 0.5 for data in <0, 1></param>
+    /// <param name="destination">Vector where to save binary image (0 below threshold, 1 elsewhere)</param>
+    /// <returns>False when table of squared values was not built.</returns>
+    bool sauvolaThreshold(const std::vector<float>& data, int radius, float k, float dynamicRange, std::vector<float>& destination) const;
+
+    /// <summary>
+    /// Sauvola's threshold of raw buffer into destination of width * height values.
+    /// </summary>
+    bool sauvolaThreshold(const float* data, int radius, float k, float dynamicRange, float* destination) const;
+
+private:
+    /// <summary> Sums of values, (height + 1) rows of width + 1 values </summary>
+    std::vector<double> sums;
+    /// <summary> Sums of squared values in the same layout, empty when not built </summary>
+    std::vector<double> squares;
+
+    /// <summary>
+    /// Calls function(index, mean, variance) for every pixel with statistics of its square window,
+    /// rows run in parallel.
+    /// </summary>
+    template <typename Function>
+    void forEachWindow(int radius, Function function) const;
+};
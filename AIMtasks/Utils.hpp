@@ -1,5 +1,12 @@
 #pragma once
 
+#include <cmath>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <execution>
+#include <thread>
+
 /// <summary>
 /// Namespace providing some utility functions or structures for using in AIM tasks.
 /// </summary>
@@ -30,6 +37,36 @@ namespace Utils
 	{
 		return expf(-(value * value) / 2.0f * (sigma * sigma));
 	}
-}
 
+	/// <summary>
+	/// Splits range of rows <0, count) into bands and processes them in parallel.
+	/// </summary>
+	/// <param name="count">Number of rows to process</param>
+	/// <param name="function">Function called as function(begin, end) for each band</param>
+	template <typename Function>
+	void ParallelBands(int count, Function function)
+	{
+		if (count <= 0) {
+			return;
+		}
 
+		// Few bands per core so that uneven bands are balanced, but still long enough runs of rows
+		int threads = std::max(1u, std::thread::hardware_concurrency());
+		int bandCount = std::clamp(threads * 4, 1, std::max(1, count));
+		int bandSize = (count + bandCount - 1) / bandCount;
+		bandCount = (count + bandSize - 1) / bandSize;
+
+		std::vector<int> bands(bandCount);
+		std::iota(bands.begin(), bands.end(), 0);
+
+		std::for_each(
+			std::execution::par,
+			bands.begin(),
+			bands.end(),
+			[&function, bandSize, count](int band) {
+				int begin = band * bandSize;
+				function(begin, std::min(count, begin + bandSize));
+			}
+		);
+	}
+}
@@ -26,6 +26,10 @@ void printHelp() {
     std::cout << "[g value] - GAMMA CORRECTION (value should be in <0, inf) range)" << std::endl;
     std::cout << "[k value] - QUANTIZATION (value should be in <0, inf) range and integer)" << std::endl;
     std::cout << "[h] - HISTOGRAM EQUALIZATION" << std::endl;
+    std::cout << "[a value] - ADAPTIVE HISTOGRAM EQUALIZATION (clip limit, value should be in <1, inf) range)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Operations are queued and applied together in one pass:" << std::endl;
+    std::cout << "[s] - APPLY QUEUED OPERATIONS AND SAVE" << std::endl;
 }
 
 /// <summary>
@@ -76,8 +80,8 @@ void Task1Main() {
         switch (operation)
         {
         case 'n':
-            std::cout << "Doing NEGATIVE operation and saving" << std::endl;
-            image.doOperation(Image::MonadicOperationType::NEGATIVE);
+            std::cout << "Queuing NEGATIVE operation" << std::endl;
+            image.queueOperation(Image::MonadicOperationType::NEGATIVE);
             break;
         case 't':
             if (0.0f >= fValue || 1.0f <= fValue) {
@@ -85,8 +89,8 @@ void Task1Main() {
                 break;
             }
 
-            std::cout << "Doing THRESHOLD (" << value << ") operation and saving" << std::endl;
-            image.doOperation(Image::MonadicOperationType::THRESHOLD, fValue);
+            std::cout << "Queuing THRESHOLD (" << value << ") operation" << std::endl;
+            image.queueOperation(Image::MonadicOperationType::THRESHOLD, fValue);
             break;
         case 'b':
             if (-1.0f >= fValue || 1.0f <= fValue) {
@@ -94,8 +98,8 @@ void Task1Main() {
                 break;
             }
 
-            std::cout << "Doing BRIGHTNESS (" << value << ") operation and saving" << std::endl;
-            image.doOperation(Image::MonadicOperationType::BRIGHTNESS, fValue);
+            std::cout << "Queuing BRIGHTNESS (" << value << ") operation" << std::endl;
+            image.queueOperation(Image::MonadicOperationType::BRIGHTNESS, fValue);
             break;
         case 'c':
             if (0.0f >= fValue) {
@@ -103,7 +107,7 @@ void Task1Main() {
                 break;
             }
 
-            image.doOperation(Image::MonadicOperationType::CONTRAST, fValue);
+            image.queueOperation(Image::MonadicOperationType::CONTRAST, fValue);
             break;
         case 'g':
             if (0.0f >= fValue) {
@@ -111,8 +115,8 @@ void Task1Main() {
                 break;
             }
 
-            std::cout << "Doing GAMMA CORECTION (" << value << ") operation and saving" << std::endl;
-            image.doOperation(Image::MonadicOperationType::GAMMA_CORRECTION, fValue);
+            std::cout << "Queuing GAMMA CORECTION (" << value << ") operation" << std::endl;
+            image.queueOperation(Image::MonadicOperationType::GAMMA_CORRECTION, fValue);
             break;
         case 'k':
             if (0.0f >= fValue) {
@@ -120,12 +124,25 @@ void Task1Main() {
                 break;
             }
 
-            std::cout << "Doing QUANTIZATION (" << value << ") operation and saving" << std::endl;
-            image.doOperation(Image::MonadicOperationType::QUANTIZATION, fValue);
+            std::cout << "Queuing QUANTIZATION (" << value << ") operation" << std::endl;
+            image.queueOperation(Image::MonadicOperationType::QUANTIZATION, fValue);
             break;
         case 'h':
-            std::cout << "Doing HISTOGRAM EQUALIZATION operation and saving" << std::endl;
-            image.doOperation(Image::MonadicOperationType::HISTOGRAM_EQUALIZATION);
+            std::cout << "Queuing HISTOGRAM EQUALIZATION operation" << std::endl;
+            image.queueOperation(Image::MonadicOperationType::HISTOGRAM_EQUALIZATION);
+            break;
+        case 'a':
+            if (1.0f > fValue) {
+                std::cout << "Please provide correct input values." << std::endl;
+                break;
+            }
+
+            std::cout << "Queuing ADAPTIVE HISTOGRAM EQUALIZATION (" << value << ") operation" << std::endl;
+            image.queueOperation(Image::MonadicOperationType::ADAPTIVE_HISTOGRAM_EQUALIZATION, fValue);
+            break;
+        case 's':
+            std::cout << "Applying queued operations and saving" << std::endl;
+            image.save("p_");
             break;
         case 'q':
             std::cout << "Quitting app" << std::endl;